@@ -0,0 +1,361 @@
+#include "dive_plan.hpp"
+#include "log.hpp"
+#include "plan_context.hpp"
+#include "thread_pool.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DiveComputer;
+
+namespace {
+
+enum class BatchMode { OC, CC, BAILOUT };
+
+struct GasMix {
+    double m_o2Percent;
+    double m_hePercent;
+};
+
+struct BatchOptions {
+    std::vector<double> m_depths;
+    std::vector<double> m_times;
+    std::vector<double> m_gfLows{g_parameters.m_gf[0]};
+    std::vector<double> m_gfHighs{g_parameters.m_gf[1]};
+    std::vector<BatchMode> m_modes{BatchMode::OC};
+    std::vector<std::vector<GasMix>> m_gasSets;
+    unsigned int m_threads{std::thread::hardware_concurrency()};
+    std::string m_output{"-"};
+    std::string m_log;
+};
+
+// One plan of the grid
+struct BatchJob {
+    double m_depth;
+    double m_time;
+    BatchMode m_mode;
+    int m_contextIndex;
+};
+
+// Settings shared by every plan with the same GF pair and gas set
+struct BatchContext {
+    double m_gfLow;
+    double m_gfHigh;
+    int m_gasSetIndex;
+    std::shared_ptr<const PlanContext> m_context;
+};
+
+void printUsage(const char* program) {
+    Log::flush();
+    std::cerr << "Usage: " << program << " --depth <range> --time <range> [options]\n"
+              << "\n"
+              << "Plans every combination of the options below and writes one CSV row per plan.\n"
+              << "A <range> is a value (30), a list (30,45,60) or start:end:step (30:60:5).\n"
+              << "\n"
+              << "  --depth <range>      bottom depths in m\n"
+              << "  --time <range>       bottom times in min\n"
+              << "  --gf-low <range>     GF low in % (default from parameters)\n"
+              << "  --gf-high <range>    GF high in % (default from parameters)\n"
+              << "  --mode <list>        oc, cc and/or bailout (default oc)\n"
+              << "  --gases <sets>       gas sets separated by ';', mixes O2/He separated by ','\n"
+              << "                       e.g. \"21/35,50/0,100/0;18/45,50/0\" (default: saved gas list)\n"
+              << "  --threads <n>        worker threads (default: all cores)\n"
+              << "  --output <file>      CSV file, '-' for stdout (default)\n"
+              << "  --log <file>         engine warnings to file, rotated at 1 MB, instead of stderr\n"
+              << "\n"
+              << "Parameters and setpoints are read from the data directory, which\n"
+              << "DIVECOMPUTER_DATA_DIR overrides.\n";
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+double parseNumber(const std::string& text) {
+    size_t used = 0;
+    double value = std::stod(text, &used);
+    if (used != text.size()) {
+        throw std::invalid_argument("'" + text + "' is not a number");
+    }
+    return value;
+}
+
+int parseInteger(const std::string& text) {
+    size_t used = 0;
+    int value = 0;
+    try {
+        value = std::stoi(text, &used);
+    }
+    catch (const std::logic_error&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size()) {
+        throw std::invalid_argument("'" + text + "' is not an integer");
+    }
+    return value;
+}
+
+std::vector<double> parseRange(const std::string& text) {
+    std::vector<double> values;
+    std::vector<std::string> bounds = split(text, ':');
+
+    if (bounds.size() == 3) {
+        double start = parseNumber(bounds[0]);
+        double end = parseNumber(bounds[1]);
+        double step = parseNumber(bounds[2]);
+        if (step <= 0.0 || end < start) {
+            throw std::invalid_argument("invalid range '" + text + "'");
+        }
+        // Integer counter so the last value is not lost to rounding
+        int count = (int) ((end - start) / step + 1e-9) + 1;
+        for (int i = 0; i < count; i++) {
+            values.push_back(start + i * step);
+        }
+    } else {
+        for (const std::string& value : split(text, ',')) {
+            values.push_back(parseNumber(value));
+        }
+    }
+
+    if (values.empty()) {
+        throw std::invalid_argument("empty range '" + text + "'");
+    }
+    return values;
+}
+
+std::vector<BatchMode> parseModes(const std::string& text) {
+    std::vector<BatchMode> modes;
+    for (const std::string& mode : split(text, ',')) {
+        if (mode == "oc") modes.push_back(BatchMode::OC);
+        else if (mode == "cc") modes.push_back(BatchMode::CC);
+        else if (mode == "bailout") modes.push_back(BatchMode::BAILOUT);
+        else throw std::invalid_argument("unknown mode '" + mode + "'");
+    }
+    return modes;
+}
+
+std::vector<std::vector<GasMix>> parseGasSets(const std::string& text) {
+    std::vector<std::vector<GasMix>> gasSets;
+    for (const std::string& set : split(text, ';')) {
+        std::vector<GasMix> gases;
+        for (const std::string& mix : split(set, ',')) {
+            std::vector<std::string> parts = split(mix, '/');
+            if (parts.size() != 2) {
+                throw std::invalid_argument("gas '" + mix + "' is not O2/He");
+            }
+            GasMix gas{parseNumber(parts[0]), parseNumber(parts[1])};
+            if (gas.m_o2Percent <= 0.0 || gas.m_hePercent < 0.0 || gas.m_o2Percent + gas.m_hePercent > 100.0) {
+                throw std::invalid_argument("invalid gas '" + mix + "'");
+            }
+            gases.push_back(gas);
+        }
+        gasSets.push_back(gases);
+    }
+    return gasSets;
+}
+
+unsigned int parseThreads(const std::string& text) {
+    int threads = parseInteger(text);
+    if (threads < 1) {
+        throw std::invalid_argument("--threads must be at least 1");
+    }
+    return (unsigned int) threads;
+}
+
+BatchOptions parseOptions(int argc, char* argv[]) {
+    BatchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h") {
+            printUsage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("missing value for " + option);
+        }
+        std::string value = argv[++i];
+
+        if (option == "--depth")        options.m_depths = parseRange(value);
+        else if (option == "--time")    options.m_times = parseRange(value);
+        else if (option == "--gf-low")  options.m_gfLows = parseRange(value);
+        else if (option == "--gf-high") options.m_gfHighs = parseRange(value);
+        else if (option == "--mode")    options.m_modes = parseModes(value);
+        else if (option == "--gases")   options.m_gasSets = parseGasSets(value);
+        else if (option == "--threads") options.m_threads = parseThreads(value);
+        else if (option == "--output")  options.m_output = value;
+        else if (option == "--log")     options.m_log = value;
+        else throw std::invalid_argument("unknown option " + option);
+    }
+
+    if (options.m_depths.empty() || options.m_times.empty()) {
+        throw std::invalid_argument("--depth and --time are required");
+    }
+    return options;
+}
+
+// Gas set as the engine's gas list: the first mix is the bottom gas or diluent, the others deco gases
+std::vector<Gas> makeGases(const std::vector<GasMix>& gasSet, const Parameters& parameters) {
+    std::vector<Gas> gases;
+    for (size_t i = 0; i < gasSet.size(); i++) {
+        GasType type = (i == 0) ? GasType::BOTTOM : GasType::DECO;
+        gases.emplace_back(gasSet[i].m_o2Percent, gasSet[i].m_hePercent, type, GasStatus::ACTIVE, parameters);
+    }
+    return gases;
+}
+
+std::string describeGasSet(const std::vector<Gas>& gases) {
+    std::ostringstream text;
+    for (size_t i = 0; i < gases.size(); i++) {
+        if (i > 0) text << ' ';
+        text << gases[i].m_o2Percent << '/' << gases[i].m_hePercent;
+    }
+    return text.str();
+}
+
+const char* getModeName(BatchMode mode) {
+    switch (mode) {
+        case BatchMode::CC:      return "cc";
+        case BatchMode::BAILOUT: return "bailout";
+        default:                 return "oc";
+    }
+}
+
+std::string planJob(const BatchJob& job, const BatchContext& batchContext, const std::string& gasSetName, size_t index) {
+    diveMode mode = (job.m_mode == BatchMode::OC) ? diveMode::OC : diveMode::CC;
+    DivePlan plan(job.m_depth, job.m_time, mode, 1, compartmentPPinitialAir, batchContext.m_context,
+                  job.m_mode == BatchMode::BAILOUT);
+
+    // The constructor calculates the plan; on failure the engine logs why and leaves it dirty
+    if (plan.isDirty() || plan.nbOfSteps() == 0) {
+        throw std::runtime_error("the engine could not calculate it");
+    }
+
+    const DiveStep& lastStep = plan.m_diveProfile[plan.nbOfSteps() - 1];
+
+    // Litres used per gas, in the order of the gas set
+    std::ostringstream gasUsed;
+    for (size_t i = 0; i < plan.m_gasAvailable.size(); i++) {
+        const GasAvailable& gas = plan.m_gasAvailable[i];
+        if (i > 0) gasUsed << ' ';
+        gasUsed << gas.m_gas.m_o2Percent << '/' << gas.m_gas.m_hePercent << '=' << (long) (gas.m_consumption + 0.5);
+    }
+
+    char row[512];
+    std::snprintf(row, sizeof(row), "%zu,%.1f,%.1f,%.0f,%.0f,%s,%s,%.1f,%.1f,%.1f,%.1f,%s\n",
+                  index, job.m_depth, job.m_time, batchContext.m_gfLow, batchContext.m_gfHigh,
+                  getModeName(job.m_mode), gasSetName.c_str(),
+                  plan.getTTS(), lastStep.m_runTime, lastStep.m_cnsTotalSingleDive, lastStep.m_otuTotal,
+                  gasUsed.str().c_str());
+    return row;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BatchOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception& e) {
+        Log::flush();
+        std::cerr << "dive_batch: " << e.what() << "\n\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!options.m_log.empty()) {
+        if (!Log::setFileSink(options.m_log)) {
+            Log::flush();
+            std::cerr << "dive_batch: cannot open " << options.m_log << std::endl;
+            return 1;
+        }
+        Log::setConsoleEnabled(false);
+    }
+
+    FILE* output = (options.m_output == "-") ? stdout : std::fopen(options.m_output.c_str(), "w");
+    if (!output) {
+        Log::flush();
+        std::cerr << "dive_batch: cannot open " << options.m_output << std::endl;
+        return 1;
+    }
+
+    // One immutable context per GF pair and gas set, shared by all the plans using it
+    std::vector<std::vector<Gas>> gasSets;
+    if (options.m_gasSets.empty()) {
+        gasSets.push_back(g_gasList.getGases());
+    }
+    std::vector<std::string> gasSetNames;
+    std::vector<BatchContext> contexts;
+
+    for (double gfLow : options.m_gfLows) {
+        for (double gfHigh : options.m_gfHighs) {
+            Parameters parameters = g_parameters;
+            parameters.m_gf[0] = gfLow;
+            parameters.m_gf[1] = gfHigh;
+
+            size_t nbGasSets = options.m_gasSets.empty() ? 1 : options.m_gasSets.size();
+            for (size_t set = 0; set < nbGasSets; set++) {
+                std::vector<Gas> gases = options.m_gasSets.empty() ? gasSets[0] : makeGases(options.m_gasSets[set], parameters);
+                if (gasSetNames.size() <= set) {
+                    gasSetNames.push_back(describeGasSet(gases));
+                }
+                contexts.push_back({gfLow, gfHigh, (int) set, std::make_shared<const PlanContext>(parameters, gases, g_setPoints)});
+            }
+        }
+    }
+
+    std::vector<BatchJob> jobs;
+    for (int context = 0; context < (int) contexts.size(); context++) {
+        for (BatchMode mode : options.m_modes) {
+            for (double depth : options.m_depths) {
+                for (double time : options.m_times) {
+                    jobs.push_back({depth, time, mode, context});
+                }
+            }
+        }
+    }
+
+    std::fprintf(output, "plan,depth_m,time_min,gf_low,gf_high,mode,gases,tts_min,runtime_min,cns_pct,otu,gas_used_l\n");
+
+    // Rows are streamed as plans complete; the plan column gives the grid order back
+    std::mutex outputMutex;
+    size_t failures = 0;
+    ThreadPool pool(options.m_threads);
+
+    pool.parallelFor(jobs.size(), [&](size_t index) {
+        const BatchJob& job = jobs[index];
+        const BatchContext& batchContext = contexts[job.m_contextIndex];
+        try {
+            std::string row = planJob(job, batchContext, gasSetNames[batchContext.m_gasSetIndex], index);
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::fputs(row.c_str(), output);
+        }
+        catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            failures++;
+            Log::flush();
+            std::cerr << "dive_batch: plan " << index << " failed: " << e.what() << std::endl;
+        }
+    });
+
+    if (output != stdout) {
+        std::fclose(output);
+    }
+
+    Log::flush();
+    std::cerr << "dive_batch: " << jobs.size() - failures << " plans on " << pool.size() << " threads" << std::endl;
+    return failures == 0 ? 0 : 2;
+}
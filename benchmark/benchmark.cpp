@@ -0,0 +1,717 @@
+#include "constants.hpp"
+#include "dive_plan.hpp"
+#include "log.hpp"
+#include "perf_counters.hpp"
+#include "plan_context.hpp"
+#include "thread_pool.hpp"
+#include "tissue_state.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+using namespace DiveComputer;
+
+// The benchmark replaces the global allocator to count heap allocations, for its
+// allocations_per_op column and the plan counters; the engine itself only keeps the count
+
+// MSVC has no aligned_alloc, and its aligned blocks need their own free
+static void* allocateAligned(std::size_t size, std::size_t align) {
+#ifdef _MSC_VER
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    std::size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+#endif
+}
+
+static void freeAligned(void* p) {
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+// As the standard operator new: the new handler is called until the allocation succeeds,
+// bad_alloc thrown when there is none. An align of 0 is the default alignment
+static void* allocate(std::size_t size, std::size_t align) {
+    while (true) {
+        void* p = (align == 0) ? std::malloc(size ? size : 1) : allocateAligned(size, align);
+        if (p) {
+            countThreadAllocation();
+            return p;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+// The array forms call these, so they are counted too
+void* operator new(std::size_t size) {
+    return allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, 0);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, static_cast<std::size_t>(alignment));
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+
+namespace {
+
+struct BenchmarkOptions {
+    int m_iterations{200};
+    int m_repeats{5};
+    int m_threads{(int) std::max(2u, std::thread::hardware_concurrency())};
+    double m_tolerance{10.0};     // in %
+    std::string m_filter;
+    std::string m_output{"-"};
+    std::string m_baseline;
+};
+
+struct GasMix {
+    double m_o2Percent;
+    double m_hePercent;
+    GasType m_gasType;
+};
+
+struct StopStep {
+    double m_depth;
+    double m_time;
+};
+
+// A representative plan of the corpus
+struct BenchmarkCase {
+    const char* m_name;
+    diveMode m_mode;
+    bool m_bailout;
+    std::vector<StopStep> m_stopSteps;     // first one is the bottom
+    std::vector<GasMix> m_gases;
+};
+
+// Cost of one operation, averaged over the iterations of the best repeat
+struct BenchmarkResult {
+    std::string m_case;
+    std::string m_benchmark;
+    int m_steps;
+    double m_microseconds;
+    double m_allocations;
+    double m_evaluations;       // applySchreiner calls
+    double m_expEvaluations;    // exp() calls made building decay terms
+};
+
+// Keeps the measured results alive, so the compiler cannot drop the work
+volatile double s_sink = 0.0;
+
+// Largest difference allowed between a shortcut and the full computation it stands for
+const double TTS_TOLERANCE = 1e-6;    // in min
+const double PP_TOLERANCE = 1e-9;     // in bar
+const double SAMPLE_TOLERANCE = 1e-6; // relative to the value, or absolute below 1; a few float ulps
+
+// Sample interval of the fine-grained time series
+const double FINE_TIME_INCREMENT = 10.0 / 60.0;   // in min
+
+void printUsage(const char* program) {
+    Log::flush();
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "\n"
+              << "Times the planning pipeline over a fixed corpus of plans and writes one CSV row\n"
+              << "per plan and benchmark. Times are the best of the repeats, per operation.\n"
+              << "\n"
+              << "  --iterations <n>     operations per repeat (default 200)\n"
+              << "  --repeats <n>        repeats, the fastest is kept (default 5)\n"
+              << "  --threads <n>        pool of the parallel benchmarks, at least 2 (default: all\n"
+              << "                       cores, at least 2)\n"
+              << "  --filter <text>      only the benchmarks whose case or name contains text\n"
+              << "  --output <file>      CSV file, '-' for stdout (default); a run saved this way\n"
+              << "                       is the baseline of later runs\n"
+              << "  --baseline <file>    CSV of a previous run to compare with; exits with 2 on a\n"
+              << "                       regression\n"
+              << "  --tolerance <pct>    slowdown or allocation growth allowed against the\n"
+              << "                       baseline (default 10)\n"
+              << "\n"
+              << "Before timing, the engine's shortcuts are checked against the full computation\n"
+              << "they stand for; the run exits with 3 if one is off by more than its tolerance.\n";
+}
+
+double parseNumber(const std::string& text) {
+    std::size_t used = 0;
+    double value = std::stod(text, &used);
+    if (used != text.size()) {
+        throw std::invalid_argument("'" + text + "' is not a number");
+    }
+    return value;
+}
+
+int parseInteger(const std::string& text) {
+    std::size_t used = 0;
+    int value = 0;
+    try {
+        value = std::stoi(text, &used);
+    }
+    catch (const std::logic_error&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size()) {
+        throw std::invalid_argument("'" + text + "' is not an integer");
+    }
+    return value;
+}
+
+BenchmarkOptions parseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h") {
+            throw std::invalid_argument("");
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("missing value for " + option);
+        }
+        std::string value = argv[++i];
+
+        if (option == "--iterations")     options.m_iterations = parseInteger(value);
+        else if (option == "--repeats")   options.m_repeats = parseInteger(value);
+        else if (option == "--threads")   options.m_threads = parseInteger(value);
+        else if (option == "--filter")    options.m_filter = value;
+        else if (option == "--output")    options.m_output = value;
+        else if (option == "--baseline")  options.m_baseline = value;
+        else if (option == "--tolerance") options.m_tolerance = parseNumber(value);
+        else throw std::invalid_argument("unknown option " + option);
+    }
+
+    if (options.m_iterations < 1 || options.m_repeats < 1) {
+        throw std::invalid_argument("--iterations and --repeats must be at least 1");
+    }
+    if (options.m_threads < 2) {
+        throw std::invalid_argument("--threads must be at least 2");
+    }
+    return options;
+}
+
+const std::vector<BenchmarkCase>& getCorpus() {
+    static const std::vector<BenchmarkCase> corpus = {
+        { "recreational_air", diveMode::OC, false, { {30.0, 40.0} },
+          { {21.0, 0.0, GasType::BOTTOM} } },
+        { "trimix_60m_oc", diveMode::OC, false, { {60.0, 25.0} },
+          { {18.0, 45.0, GasType::BOTTOM}, {50.0, 0.0, GasType::DECO}, {100.0, 0.0, GasType::DECO} } },
+        { "cc_100m_bailout", diveMode::CC, true, { {100.0, 20.0} },
+          { {10.0, 70.0, GasType::DILUENT}, {15.0, 55.0, GasType::BOTTOM}, {21.0, 35.0, GasType::DECO},
+            {50.0, 0.0, GasType::DECO}, {100.0, 0.0, GasType::DECO} } },
+        { "multi_level", diveMode::OC, false, { {45.0, 20.0}, {30.0, 15.0}, {21.0, 10.0} },
+          { {21.0, 35.0, GasType::BOTTOM}, {50.0, 0.0, GasType::DECO}, {100.0, 0.0, GasType::DECO} } },
+    };
+    return corpus;
+}
+
+// Synthetic profile long enough for the parallel tissue scan, standing for an imported log:
+// a slow ascent from 120 m with a planned stop every 15 cm, three steps each
+const BenchmarkCase& getLongCase() {
+    static const BenchmarkCase longCase = [] {
+        BenchmarkCase benchmarkCase{ "long_ascent", diveMode::OC, false, { {120.0, 20.0} },
+                                     { {18.0, 45.0, GasType::BOTTOM}, {50.0, 0.0, GasType::DECO}, {100.0, 0.0, GasType::DECO} } };
+        for (int depth = 11985; depth >= 600; depth -= 15) {
+            benchmarkCase.m_stopSteps.push_back({depth / 100.0, 0.1});
+        }
+        return benchmarkCase;
+    }();
+    return longCase;
+}
+
+std::unique_ptr<DivePlan> makePlan(const BenchmarkCase& benchmarkCase, const Parameters& parameters = g_parameters) {
+    std::vector<Gas> gases;
+    for (const GasMix& mix : benchmarkCase.m_gases) {
+        gases.emplace_back(mix.m_o2Percent, mix.m_hePercent, mix.m_gasType, GasStatus::ACTIVE, parameters);
+    }
+    auto context = std::make_shared<const PlanContext>(parameters, gases, g_setPoints);
+
+    const StopStep& bottom = benchmarkCase.m_stopSteps[0];
+    auto plan = std::make_unique<DivePlan>(bottom.m_depth, bottom.m_time, benchmarkCase.m_mode, 1,
+                                           compartmentPPinitialAir, context);
+
+    plan->m_bailout = benchmarkCase.m_bailout;
+    for (size_t i = 1; i < benchmarkCase.m_stopSteps.size(); i++) {
+        plan->m_stopSteps.addStopStep(benchmarkCase.m_stopSteps[i].m_depth, benchmarkCase.m_stopSteps[i].m_time);
+    }
+    plan->build();
+    plan->calculate();
+    return plan;
+}
+
+// Long profile sampled every 10 s
+std::unique_ptr<DivePlan> makeFinePlan() {
+    Parameters parameters = g_parameters;
+    parameters.m_timeIncrementDeco = FINE_TIME_INCREMENT;
+    return makePlan(getLongCase(), parameters);
+}
+
+// Best of the repeats of iterations calls to operation, after one warm-up call
+BenchmarkResult measure(const BenchmarkOptions& options, const std::string& caseName, const std::string& name,
+                        int steps, const std::function<void()>& operation) {
+    BenchmarkResult best{caseName, name, steps, 0.0, 0.0, 0.0, 0.0};
+    operation();
+
+    for (int repeat = 0; repeat < options.m_repeats; repeat++) {
+        unsigned long long allocationsBefore = getThreadAllocationCount();
+        SchreinerStats before = getSchreinerStats();
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < options.m_iterations; i++) {
+            operation();
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        SchreinerStats after = getSchreinerStats();
+        unsigned long long allocationsAfter = getThreadAllocationCount();
+
+        double microseconds = std::chrono::duration<double, std::micro>(end - start).count() / options.m_iterations;
+        if (repeat == 0 || microseconds < best.m_microseconds) {
+            best.m_microseconds = microseconds;
+            best.m_allocations = double(allocationsAfter - allocationsBefore) / options.m_iterations;
+            best.m_evaluations = double(after.m_evaluations - before.m_evaluations) / options.m_iterations;
+            best.m_expEvaluations = double(after.m_expEvaluations - before.m_expEvaluations) / options.m_iterations;
+        }
+    }
+    return best;
+}
+
+void runCase(const BenchmarkOptions& options, const BenchmarkCase& benchmarkCase, std::vector<BenchmarkResult>& results) {
+    std::unique_ptr<DivePlan> plan = makePlan(benchmarkCase);
+    DivePlan& divePlan = *plan;
+    const PlanContext& context = divePlan.getContext();
+    int steps = divePlan.nbOfSteps();
+
+    auto run = [&](const char* name, const std::function<void()>& operation) {
+        std::string caseName = benchmarkCase.m_name;
+        if (!options.m_filter.empty() && caseName.find(options.m_filter) == std::string::npos &&
+            std::string(name).find(options.m_filter) == std::string::npos) {
+            return;
+        }
+        results.push_back(measure(options, caseName, name, steps, operation));
+    };
+
+    // Whole pipeline: profile from the stop steps, then every stage of calculate()
+    run("build_calculate", [&] {
+        divePlan.build();
+        divePlan.calculate();
+    });
+
+    // Gases, tissue loading and deco stops (applyGases, calculatePPInertGas), then the variables
+    run("calculate_tissues", [&] {
+        divePlan.invalidate(PlanStage::TISSUES);
+        divePlan.calculate();
+    });
+
+    // Per step values only: ceiling, GF surface, density, END, oxygen toxicity, consumption
+    run("calculate_variables", [&] {
+        divePlan.invalidate(PlanStage::VARIABLES);
+        divePlan.calculate();
+    });
+
+    // Tissue loading of the profile as it stands, step after step
+    std::vector<DiveStep> replay = divePlan.m_diveProfile;
+    run("tissue_loading", [&] {
+        for (size_t i = 1; i < replay.size(); i++) {
+            replay[i].calculatePPInertGasForStep(replay[i - 1], replay[i].m_time, context);
+        }
+        s_sink = replay.back().m_ppActual.pN2(0);
+    });
+
+    run("ceiling_gf_surface", [&] {
+        double total = 0.0;
+        for (DiveStep& step : replay) {
+            total += step.getCeiling(step.m_gf, context) + step.getGFSurface(&replay.back(), context);
+        }
+        s_sink = total;
+    });
+
+    std::vector<double> ppO2;
+    std::vector<double> times;
+    for (const DiveStep& step : divePlan.m_diveProfile) {
+        ppO2.push_back(step.m_pO2Max);
+        times.push_back(step.m_time);
+    }
+    run("oxygen_toxicity_lookup", [&] {
+        double total = 0.0;
+        for (double p : ppO2) {
+            total += context.m_oxygenToxicity.getCNSMaxMin(p, true) + context.m_oxygenToxicity.getCNSMaxMin(p, false) +
+                     context.m_oxygenToxicity.getOTUPerMin(p);
+        }
+        s_sink = total;
+    });
+
+    run("oxygen_toxicity_dose", [&] {
+        O2Dose dose = context.m_oxygenToxicity.getDose(ppO2.data(), times.data(), ppO2.size());
+        s_sink = dose.m_cnsSingleDive + dose.m_otu;
+    });
+
+    // Direct ascent leaving 5 min after the bottom phase, from its last checkpoint
+    double bottomEnd = divePlan.m_diveProfile.back().m_runTime - divePlan.getTTS();
+    run("what_if_ascent", [&] {
+        s_sink = divePlan.getTTSIfAscentAt(bottomEnd + 5.0);
+    });
+
+    // Tissues of a repetitive dive after 90 min at the surface, in one step
+    run("surface_interval", [&] {
+        s_sink = divePlan.getTissuesAfterSurfaceInterval(90.0)[0].m_pN2;
+    });
+
+    // Samples every deco time increment, read in order
+    run("time_profile", [&] {
+        TimeProfile profile = divePlan.getTimeProfile();
+        double total = 0.0;
+        for (const DiveStep& sample : profile) {
+            total += sample.m_ppActual.pN2(0);
+        }
+        s_sink = total;
+    });
+}
+
+// Prints a check; true if its error is within tolerance
+bool reportCheck(const std::string& name, double error, double tolerance) {
+    bool passed = (error <= tolerance);
+    Log::flush();
+    std::fprintf(stderr, "  check %-40s max error %10.3g  (tolerance %.3g)%s\n", name.c_str(), error, tolerance,
+                 passed ? "" : "  FAILED");
+    return passed;
+}
+
+// getTTSIfAscentAt() from the checkpoints, against the full plan with its last planned stop
+// shortened or lengthened so that the ascent leaves at the same time
+double checkWhatIfAscent(const BenchmarkCase& benchmarkCase) {
+    std::unique_ptr<DivePlan> plan = makePlan(benchmarkCase);
+    int lastStop = plan->m_stopSteps.nbOfStopSteps() - 1;
+    double stopTime = plan->m_stopSteps.m_stopSteps[lastStop].m_time;
+    double bottomEnd = plan->m_diveProfile.back().m_runTime - plan->getTTS();
+
+    double error = 0.0;
+    for (double delta : {-stopTime / 2.0, 0.0, 5.0, 20.0}) {
+        DivePlan full(*plan);
+        full.editStopStepTime(lastStop, stopTime + delta);
+        full.calculate();
+        error = std::max(error, std::abs(plan->getTTSIfAscentAt(bottomEnd + delta) - full.getTTS()));
+    }
+    return error;
+}
+
+// getTissuesAfterSurfaceInterval(), a single transform for the whole interval, against one minute
+// Schreiner steps on air at the surface, and against the composition of their transforms
+double checkSurfaceInterval(const BenchmarkCase& benchmarkCase) {
+    std::unique_ptr<DivePlan> plan = makePlan(benchmarkCase);
+    const TissueState& endOfDive = plan->m_diveProfile.back().m_ppActual;
+    double pAmb = getPressureFromDepth(0.0);
+    double n2Percent = 100.0 - g_constants.m_oxygenInAir;
+
+    SchreinerDecay scratch;
+    const SchreinerDecay& minute = plan->getContext().m_buhlmannModel.getDecay(1.0, scratch);
+    TissueTransform minuteTransform = TissueTransform::fromSegment(minute, pAmb, pAmb, n2Percent, 0.0);
+
+    double error = 0.0;
+    for (int interval : {10, 90, 360}) {
+        std::vector<CompartmentPP> fastForward = plan->getTissuesAfterSurfaceInterval(interval);
+
+        TissueState stepped = endOfDive;
+        TissueTransform composed = TissueTransform::identity();
+        for (int i = 0; i < interval; i++) {
+            TissueState next;
+            applySchreiner(stepped, next, minute, pAmb, pAmb, n2Percent, 0.0);
+            stepped = next;
+            composed = composed.then(minuteTransform);
+        }
+
+        TissueState composedTissues;
+        composed.apply(endOfDive, composedTissues);
+
+        for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+            error = std::max({error, std::abs(fastForward[j].m_pN2 - stepped.pN2(j)), std::abs(fastForward[j].m_pHe - stepped.pHe(j)),
+                              std::abs(composedTissues.pN2(j) - stepped.pN2(j)), std::abs(composedTissues.pHe(j) - stepped.pHe(j))});
+        }
+    }
+    return error;
+}
+
+// Tissue loading of the long profile by the parallel prefix scan, against the serial scan
+double checkParallelScan(ThreadPool& pool) {
+    std::unique_ptr<DivePlan> serial = makePlan(getLongCase());
+    std::unique_ptr<DivePlan> parallel = makePlan(getLongCase());
+    if (serial->nbOfSteps() < PARALLEL_SCAN_MIN_STEPS) {
+        throw std::logic_error("long_ascent is too short for the parallel scan");
+    }
+
+    parallel->setThreadPool(&pool);
+    parallel->invalidate(PlanStage::TISSUES);
+    parallel->calculate();
+    if (parallel->nbOfSteps() != serial->nbOfSteps()) {
+        return HUGE_VAL;
+    }
+
+    double error = 0.0;
+    for (int i = 0; i < serial->nbOfSteps(); i++) {
+        const TissueState& a = serial->m_diveProfile[i].m_ppActual;
+        const TissueState& b = parallel->m_diveProfile[i].m_ppActual;
+        for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+            error = std::max({error, std::abs(a.pN2(j) - b.pN2(j)), std::abs(a.pHe(j) - b.pHe(j))});
+        }
+    }
+    return error;
+}
+
+double getColumnError(const std::vector<float>& a, const std::vector<float>& b) {
+    double error = 0.0;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        error = std::max(error, std::abs((double) a[i] - b[i]) / std::max(1.0, std::abs((double) a[i])));
+    }
+    return error;
+}
+
+// Time series of the long profile every 10 s, filled in chunks on the pool, against the serial fill
+double checkTimeSeries(ThreadPool& pool) {
+    std::unique_ptr<DivePlan> plan = makeFinePlan();
+    TimeSeries serial = plan->getTimeSeries();
+    if (serial.size() < 2 * TIME_SERIES_CHUNK) {
+        throw std::logic_error("long_ascent is too short for the parallel time series");
+    }
+
+    plan->setThreadPool(&pool);
+    TimeSeries parallel = plan->getTimeSeries();
+    if (parallel.size() != serial.size() || parallel.m_runs.size() != serial.m_runs.size()) {
+        return HUGE_VAL;
+    }
+
+    double error = std::max({getColumnError(serial.m_runTime, parallel.m_runTime), getColumnError(serial.m_depth, parallel.m_depth),
+                             getColumnError(serial.m_cnsTotalSingleDive, parallel.m_cnsTotalSingleDive),
+                             getColumnError(serial.m_cnsTotalMultipleDives, parallel.m_cnsTotalMultipleDives),
+                             getColumnError(serial.m_otuTotal, parallel.m_otuTotal), getColumnError(serial.m_gfSurface, parallel.m_gfSurface)});
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        error = std::max({error, getColumnError(serial.m_pN2[j], parallel.m_pN2[j]), getColumnError(serial.m_pHe[j], parallel.m_pHe[j])});
+    }
+    return error;
+}
+
+// Returns the number of failed checks
+int runChecks(ThreadPool& pool) {
+    int failures = 0;
+
+    for (const BenchmarkCase& benchmarkCase : getCorpus()) {
+        std::string caseName = benchmarkCase.m_name;
+        failures += !reportCheck(caseName + " what_if_ascent", checkWhatIfAscent(benchmarkCase), TTS_TOLERANCE);
+        failures += !reportCheck(caseName + " surface_interval", checkSurfaceInterval(benchmarkCase), PP_TOLERANCE);
+    }
+    failures += !reportCheck("long_ascent parallel_scan", checkParallelScan(pool), PP_TOLERANCE);
+    failures += !reportCheck("long_ascent time_series_10s", checkTimeSeries(pool), SAMPLE_TOLERANCE);
+    return failures;
+}
+
+// Loading of the long profile and its time series every 10 s, on the calling thread then on the pool
+void runLongCase(const BenchmarkOptions& options, ThreadPool& pool, std::vector<BenchmarkResult>& results) {
+    const BenchmarkCase& benchmarkCase = getLongCase();
+    std::unique_ptr<DivePlan> plan = makePlan(benchmarkCase);
+    DivePlan& divePlan = *plan;
+    std::unique_ptr<DivePlan> finePlan = makeFinePlan();
+    int steps = divePlan.nbOfSteps();
+
+    auto run = [&](const char* name, const std::function<void()>& operation) {
+        std::string caseName = benchmarkCase.m_name;
+        if (!options.m_filter.empty() && caseName.find(options.m_filter) == std::string::npos &&
+            std::string(name).find(options.m_filter) == std::string::npos) {
+            return;
+        }
+        results.push_back(measure(options, caseName, name, steps, operation));
+    };
+
+    run("calculate_tissues", [&] {
+        divePlan.invalidate(PlanStage::TISSUES);
+        divePlan.calculate();
+    });
+
+    run("time_series_10s", [&] {
+        s_sink = finePlan->getTimeSeries().m_pN2[0].back();
+    });
+
+    // Schreiner evaluations on the pool's workers are not counted in these rows
+    divePlan.setThreadPool(&pool);
+    run("calculate_tissues_parallel", [&] {
+        divePlan.invalidate(PlanStage::TISSUES);
+        divePlan.calculate();
+    });
+
+    finePlan->setThreadPool(&pool);
+    run("time_series_10s_parallel", [&] {
+        s_sink = finePlan->getTimeSeries().m_pN2[0].back();
+    });
+}
+
+void writeResults(const std::vector<BenchmarkResult>& results, FILE* output) {
+    std::fprintf(output, "case,benchmark,steps,us_per_op,allocations_per_op,schreiner_per_op,exp_per_op\n");
+    for (const BenchmarkResult& result : results) {
+        std::fprintf(output, "%s,%s,%d,%.3f,%.3f,%.3f,%.3f\n", result.m_case.c_str(), result.m_benchmark.c_str(),
+                     result.m_steps, result.m_microseconds, result.m_allocations, result.m_evaluations,
+                     result.m_expEvaluations);
+    }
+}
+
+std::map<std::string, BenchmarkResult> readBaseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open baseline " + path);
+    }
+
+    std::map<std::string, BenchmarkResult> baseline;
+    std::string line;
+    std::getline(file, line);   // header
+
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 7) {
+            throw std::runtime_error("invalid baseline row '" + line + "'");
+        }
+
+        BenchmarkResult result{fields[0], fields[1], (int) parseNumber(fields[2]), parseNumber(fields[3]),
+                               parseNumber(fields[4]), parseNumber(fields[5]), parseNumber(fields[6])};
+        baseline[result.m_case + "/" + result.m_benchmark] = result;
+    }
+    return baseline;
+}
+
+// Prints each benchmark against the baseline; returns the number of regressions
+int compareWithBaseline(const std::vector<BenchmarkResult>& results, const std::map<std::string, BenchmarkResult>& baseline,
+                        double tolerance) {
+    int regressions = 0;
+    double limit = 1.0 + tolerance / 100.0;
+
+    for (const BenchmarkResult& result : results) {
+        auto found = baseline.find(result.m_case + "/" + result.m_benchmark);
+        if (found == baseline.end()) {
+            std::fprintf(stderr, "  %-20s %-24s %10.3f us   (not in baseline)\n",
+                         result.m_case.c_str(), result.m_benchmark.c_str(), result.m_microseconds);
+            continue;
+        }
+
+        const BenchmarkResult& before = found->second;
+        double ratio = (before.m_microseconds > 0.0) ? result.m_microseconds / before.m_microseconds : 1.0;
+        bool slower = ratio > limit;
+        bool moreAllocations = result.m_allocations > before.m_allocations * limit + 1e-9;
+        if (slower || moreAllocations) {
+            regressions++;
+        }
+
+        std::fprintf(stderr, "  %-20s %-24s %10.3f us  %+7.1f %%  allocations %.3f -> %.3f%s\n",
+                     result.m_case.c_str(), result.m_benchmark.c_str(), result.m_microseconds, 100.0 * (ratio - 1.0),
+                     before.m_allocations, result.m_allocations, (slower || moreAllocations) ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception& e) {
+        Log::flush();
+        if (*e.what()) std::cerr << "dive_benchmark: " << e.what() << "\n\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, BenchmarkResult> baseline;
+    try {
+        if (!options.m_baseline.empty()) {
+            baseline = readBaseline(options.m_baseline);
+        }
+    }
+    catch (const std::exception& e) {
+        Log::flush();
+        std::cerr << "dive_benchmark: " << e.what() << std::endl;
+        return 1;
+    }
+
+    FILE* output = (options.m_output == "-") ? stdout : std::fopen(options.m_output.c_str(), "w");
+    if (!output) {
+        Log::flush();
+        std::cerr << "dive_benchmark: cannot open " << options.m_output << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool(options.m_threads);
+
+    Log::flush();
+    std::cerr << "Checks:" << std::endl;
+    if (runChecks(pool) > 0) {
+        return 3;
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const BenchmarkCase& benchmarkCase : getCorpus()) {
+        runCase(options, benchmarkCase, results);
+    }
+    runLongCase(options, pool, results);
+
+    writeResults(results, output);
+    if (output != stdout) {
+        std::fclose(output);
+    }
+
+    if (baseline.empty()) {
+        return 0;
+    }
+
+    Log::flush();
+    std::cerr << "Against " << options.m_baseline << " (tolerance " << options.m_tolerance << " %):" << std::endl;
+    int regressions = compareWithBaseline(results, baseline, options.m_tolerance);
+    std::cerr << regressions << " regression(s)" << std::endl;
+    return (regressions > 0) ? 2 : 0;
+}
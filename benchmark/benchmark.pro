@@ -0,0 +1,10 @@
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = dive_benchmark
+
+include(../common.pri)
+include(../engine.pri)
+
+SOURCES += \
+    benchmark.cpp
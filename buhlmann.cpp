@@ -1,10 +1,9 @@
 #include "buhlmann.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace DiveComputer {
 
-// Initialize global BuhlmannModel instance
-BuhlmannModel g_buhlmannModel;
-
 BuhlmannModel::BuhlmannModel() {
     // Initialize with Buhlmann parameters zh_l16C
     // Format: N2-1/2t, N2 a, N2 b, He-1/2t, He a, He b
@@ -27,6 +26,48 @@ BuhlmannModel::BuhlmannModel() {
         /*   Compartment 15 */ CompartmentParameters(498.0, 0.2480, 0.9602, 188.24, 0.5172, 0.9217),
         /*   Compartment 16 */ CompartmentParameters(635.0, 0.2327, 0.9653, 240.03, 0.5119, 0.9267)
     }};
+
+    updateRateConstants();
+}
+
+void BuhlmannModel::updateRateConstants() {
+    m_rateConstants.fill(0.0);
+
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        m_rateConstants[j] = log(2) / m_compartments[j].m_halfTimeN2;
+        m_rateConstants[COMPARTMENT_STRIDE + j] = log(2) / m_compartments[j].m_halfTimeHe;
+    }
+}
+
+void BuhlmannModel::prepareDecayCache(const std::vector<double>& durations) {
+    // Nothing to do if the same durations are already cached
+    bool upToDate = (m_decayCacheCount == (int) std::min(durations.size(), (size_t) DECAY_CACHE_SIZE));
+    for (int i = 0; upToDate && i < m_decayCacheCount; i++) {
+        upToDate = (m_decayCache[i].m_time == durations[i]);
+    }
+    if (upToDate) return;
+
+    clearDecayCache();
+    for (double time : durations) {
+        if (m_decayCacheCount == DECAY_CACHE_SIZE) break;
+        computeSchreinerDecay(m_rateConstants, time, m_decayCache[m_decayCacheCount]);
+        m_decayCacheCount++;
+    }
+}
+
+void BuhlmannModel::clearDecayCache() {
+    m_decayCacheCount = 0;
+}
+
+const SchreinerDecay& BuhlmannModel::getDecay(double time, SchreinerDecay& scratch) const {
+    for (int i = 0; i < m_decayCacheCount; i++) {
+        if (std::abs(m_decayCache[i].m_time - time) < 1e-9) {
+            return m_decayCache[i];
+        }
+    }
+
+    computeSchreinerDecay(m_rateConstants, time, scratch);
+    return scratch;
 }
 
 } // namespace DiveComputer
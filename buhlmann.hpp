@@ -2,7 +2,9 @@
 #define BUHLMANN_HPP
 
 #include "compartments.hpp"
+#include "tissue_state.hpp"
 #include <array>
+#include <vector>
 
 namespace DiveComputer {
 
@@ -15,12 +17,26 @@ public:
     // Getter for compartments
     const CompartmentParameters& getCompartment(int index) const { return m_compartments[index]; }
 
+    // Decay factors for the step durations used on the hot path (deco increment, gas switch, ascent segments)
+    void prepareDecayCache(const std::vector<double>& durations);
+    void clearDecayCache();
+
+    // Returns the cached decay for this duration, or computes it into scratch on a miss
+    const SchreinerDecay& getDecay(double time, SchreinerDecay& scratch) const;
+
     // Initialise with Buhlmann parameters zh_l16C
     std::array<CompartmentParameters, NUM_COMPARTMENTS> m_compartments;
-};
 
-// Global instance - will be defined in buhlmann.cpp
-extern BuhlmannModel g_buhlmannModel;
+    // k = ln(2) / half-time, laid out like the TissueState lanes
+    alignas(32) std::array<double, TISSUE_LANES> m_rateConstants{};
+
+private:
+    static constexpr int DECAY_CACHE_SIZE = 8;
+    std::array<SchreinerDecay, DECAY_CACHE_SIZE> m_decayCache;
+    int m_decayCacheCount{0};
+
+    void updateRateConstants();
+};
 
 } // namespace DiveComputer
 
@@ -0,0 +1,50 @@
+# Settings shared by the engine library, the GUI and the command line tools
+CONFIG += c++17 thread
+
+# Opt-in AVX2 build of the tissue kernel (SSE2 is the x86_64 baseline): qmake CONFIG+=avx2
+avx2 {
+    QMAKE_CXXFLAGS += -mavx2
+}
+
+# Opt-in trace spans of the planning pipeline and the GUI, exported from File > Export trace: qmake CONFIG+=trace
+trace {
+    DEFINES += DIVECOMPUTER_TRACE
+}
+
+# Debug and trace log records are compiled out unless asked for: qmake CONFIG+=log_debug or CONFIG+=log_trace
+log_debug {
+    DEFINES += DIVECOMPUTER_LOG_LEVEL=1
+}
+log_trace {
+    DEFINES += DIVECOMPUTER_LOG_LEVEL=0
+}
+
+macx {
+    # Determine SDK path dynamically
+    SDK_PATH = $$system(xcrun --show-sdk-path)
+    isEmpty(SDK_PATH) {
+        error("Could not determine SDK path. Make sure Xcode and Command Line Tools are properly installed.")
+    }
+    
+    message("Using SDK path: $$SDK_PATH")
+    
+    # Use dynamically determined SDK path
+    QMAKE_CXXFLAGS += -isysroot $$SDK_PATH
+    QMAKE_LFLAGS += -isysroot $$SDK_PATH
+    
+    # Set the minimum macOS version to match your system
+    QMAKE_MACOSX_DEPLOYMENT_TARGET = 14.0
+    
+    # Make sure the C++ standard library headers come first in search path
+    QMAKE_CXXFLAGS += -stdlib=libc++
+    
+    # Fix the include path order - libc++ headers must come before system headers
+    INCLUDEPATH = $$SDK_PATH/usr/include/c++/v1 $$INCLUDEPATH
+    INCLUDEPATH += $$SDK_PATH/usr/include
+    
+    # Explicitly specify the C++ standard to avoid gnu extensions
+    QMAKE_CXXFLAGS += -std=c++17
+    
+    # Remove any conflicting flags that might be causing issues
+    QMAKE_CXXFLAGS -= -std=gnu++1z
+}
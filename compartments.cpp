@@ -29,10 +29,13 @@ CompartmentPP& CompartmentPP::operator=(const CompartmentPP& other) {
     return *this;
 }
 
+// Local instance: g_constants lives in another translation unit and may not be initialised yet
+static const Constants constantsAtInit;
+
 const CompartmentPP compartmentAir(
-    (g_constants.m_atmPressureStp - g_constants.m_pH2O) * (1.0 - g_constants.m_oxygenInAir / 100.0), 
+    (constantsAtInit.m_atmPressureStp - constantsAtInit.m_pH2O) * (1.0 - constantsAtInit.m_oxygenInAir / 100.0), 
     0.0, 
-    (g_constants.m_atmPressureStp - g_constants.m_pH2O) * (1.0 - g_constants.m_oxygenInAir / 100.0)
+    (constantsAtInit.m_atmPressureStp - constantsAtInit.m_pH2O) * (1.0 - constantsAtInit.m_oxygenInAir / 100.0)
 );
 
 std::vector<CompartmentPP> compartmentPPinitialAir(NUM_COMPARTMENTS, compartmentAir);
@@ -1,15 +1,34 @@
 #include "dive_plan.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include "perf_counters.hpp"
+#include "log.hpp"
 #include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
 
 
 namespace DiveComputer {
 
 DivePlan::DivePlan(double depth, double time, diveMode mode, int diveNumber, std::vector<CompartmentPP> initialPressure)
+    : DivePlan(depth, time, mode, diveNumber, initialPressure, PlanContext::fromGlobals())
+{
+}
+
+DivePlan::DivePlan(double depth, double time, diveMode mode, int diveNumber, std::vector<CompartmentPP> initialPressure,
+                   std::shared_ptr<const PlanContext> context, bool bailout)
+    : m_bailout(bailout)
+    , m_setPoints(context->m_setPoints)
+    , m_context(std::move(context))
 {
     m_diveNumber = diveNumber;
     m_mode = mode;
 
-    m_initialPressure = initialPressure;
+    m_initialPressure = TissueState(initialPressure);
     
     m_stopSteps.clear();
     m_stopSteps.addStopStep(depth, time);
@@ -27,11 +46,117 @@ DivePlan::DivePlan(double depth, double time, diveMode mode, int diveNumber, std
     updateGasConsumption();
 }
 
+// Cheapest stage that covers the settings changed between two snapshots.
+// The gas inventory is left out: the plan works on its own m_gasAvailable and m_setPoints
+static PlanStage getContextChange(const PlanContext& before, const PlanContext& after) {
+    const Parameters& a = before.m_parameters;
+    const Parameters& b = after.m_parameters;
+
+    if (a.m_maxAscentRate != b.m_maxAscentRate || a.m_maxDescentRate != b.m_maxDescentRate ||
+        a.m_depthIncrement != b.m_depthIncrement || a.m_lastStopDepth != b.m_lastStopDepth) {
+        return PlanStage::PROFILE;
+    }
+
+    if (a.m_gf[0] != b.m_gf[0] || a.m_gf[1] != b.m_gf[1] || a.m_atmPressure != b.m_atmPressure ||
+        a.m_PpO2Active != b.m_PpO2Active || a.m_PpO2Deco != b.m_PpO2Deco ||
+        a.m_maxPpO2Diluent != b.m_maxPpO2Diluent || a.m_timeIncrementDeco != b.m_timeIncrementDeco) {
+        return PlanStage::TISSUES;
+    }
+
+    if (a.m_tempMin != b.m_tempMin || a.m_defaultEnd != b.m_defaultEnd ||
+        a.m_defaultO2Narcotic != b.m_defaultO2Narcotic) {
+        return PlanStage::VARIABLES;
+    }
+
+    if (a.m_sacBottom != b.m_sacBottom || a.m_sacBailout != b.m_sacBailout || a.m_sacDeco != b.m_sacDeco) {
+        return PlanStage::CONSUMPTION;
+    }
+
+    return PlanStage::NONE;
+}
+
+DivePlan::DivePlan(const DivePlan& plan, double depth, const TissueState& tissues)
+    : m_mode(plan.m_mode)
+    , m_bailout(plan.m_bailout)
+    , m_diveNumber(plan.m_diveNumber)
+    , m_boosted(plan.m_boosted)
+    , m_setPoints(plan.m_setPoints)
+    , m_initialPressure(tissues)
+    , m_gasAvailable(plan.m_gasAvailable)
+    , m_context(plan.m_context)
+    , m_gasChoices(plan.m_gasChoices)
+{
+    m_stopSteps.addStopStep(depth, 0.0);
+    buildAscent();
+    calculateSteps();
+}
+
+void DivePlan::setContext(std::shared_ptr<const PlanContext> context) {
+    bool temperatureChanged = false;
+    bool ppO2Changed = false;
+    if (m_context && context != m_context) {
+        const Parameters& a = m_context->m_parameters;
+        const Parameters& b = context->m_parameters;
+
+        invalidate(getContextChange(*m_context, *context));
+        temperatureChanged = (a.m_tempMin != b.m_tempMin);
+        ppO2Changed = (a.m_PpO2Active != b.m_PpO2Active || a.m_PpO2Deco != b.m_PpO2Deco ||
+                       a.m_maxPpO2Diluent != b.m_maxPpO2Diluent);
+    }
+    m_context = std::move(context);
+
+    if (temperatureChanged) {
+        updateGasProperties();
+    }
+    if (ppO2Changed) {
+        updateGasChoices();
+    }
+}
+
+void DivePlan::invalidate(PlanStage stage, int fromStep) {
+    if (stage == PlanStage::NONE) return;
+
+    m_dirtyStage = std::max(m_dirtyStage, stage);
+    if (stage >= PlanStage::TISSUES) {
+        m_firstDirtyStep = std::min(m_firstDirtyStep, std::max(fromStep, 0));
+    }
+}
+
+void DivePlan::editStopStepTime(int stopStep, double time) {
+    if (stopStep < 0 || stopStep >= m_stopSteps.nbOfStopSteps()) return;
+
+    double depth = m_stopSteps.m_stopSteps[stopStep].m_depth;
+    m_stopSteps.editStopStep(stopStep, depth, time);
+
+    // The STOP step at that depth, the surface step excepted
+    for (int i = 1; i < nbOfSteps(); i++) {
+        if (m_diveProfile[i].m_phase == Phase::STOP && std::abs(m_diveProfile[i].m_startDepth - depth) < 0.1) {
+            m_diveProfile[i].m_time = time;
+            invalidate(PlanStage::TISSUES, i);
+            return;
+        }
+    }
+
+    invalidate(PlanStage::PROFILE);
+}
+
+// Density coefficients follow the temperature of the context; the mixes themselves are unchanged
+void DivePlan::updateGasProperties() {
+    const Parameters& parameters = m_context->m_parameters;
+
+    for (auto& gas : m_gasAvailable) {
+        gas.m_gas.m_properties = GasProperties(gas.m_gas.m_o2Percent, gas.m_gas.m_hePercent, parameters);
+    }
+    for (auto& step : m_diveProfile) {
+        step.m_gasProperties = GasProperties(step.m_o2Percent, step.m_hePercent, parameters);
+    }
+}
+
 // Core methods
 void DivePlan::loadAvailableGases() {
     m_gasAvailable.clear();
     
-    for (const auto& gas : g_gasList.getGases()) {
+    for (const auto& gas : m_context->m_gases) {
         // Only add active gases
         if (gas.m_gasStatus == GasStatus::ACTIVE) {
             m_gasAvailable.emplace_back(gas);
@@ -40,12 +165,50 @@ void DivePlan::loadAvailableGases() {
     
     // Ensure we have at least one gas (air as default)
     if (m_gasAvailable.empty()) {
-        Gas defaultGas(g_constants.m_oxygenInAir, 0.0, GasType::BOTTOM, GasStatus::ACTIVE);
+        Gas defaultGas(g_constants.m_oxygenInAir, 0.0, GasType::BOTTOM, GasStatus::ACTIVE, m_context->m_parameters);
         m_gasAvailable.emplace_back(defaultGas);
     }
+
+    // Sorted once here: the steps keep indices into this list
+    sortGases();
+    updateGasChoices();
+}
+
+void DivePlan::updateGasChoices() {
+    for (int mode = 0; mode < NUM_STEP_MODES; mode++) {
+        double maxppO2 = m_context->getMaxPpO2(static_cast<stepMode>(mode));
+        std::vector<GasChoice>& choices = m_gasChoices[mode];
+
+        choices.clear();
+        for (int i = 0; i < (int) m_gasAvailable.size(); i++) {
+            choices.push_back({m_gasAvailable[i].m_gas.MOD(maxppO2), i});
+        }
+
+        // Of gases with the same MOD, the first in the inventory is the one selected
+        std::stable_sort(choices.begin(), choices.end(),
+                         [](const GasChoice& a, const GasChoice& b) { return a.m_MOD < b.m_MOD; });
+        choices.erase(std::unique(choices.begin(), choices.end(),
+                                  [](const GasChoice& a, const GasChoice& b) { return a.m_MOD == b.m_MOD; }),
+                      choices.end());
+    }
+}
+
+// Gas with the smallest MOD reaching depth, else the first of the inventory (the lowest O2 content)
+int DivePlan::selectGas(stepMode mode, double depth) const {
+    const std::vector<GasChoice>& choices = m_gasChoices[static_cast<int>(mode)];
+    auto choice = std::lower_bound(choices.begin(), choices.end(), depth,
+                                   [](const GasChoice& a, double d) { return a.m_MOD < d; });
+    return (choice != choices.end()) ? choice->m_gasIndex : 0;
+}
+
+void DivePlan::build(std::shared_ptr<const PlanContext> context){
+    setContext(std::move(context));
+    build();
 }
 
 void DivePlan::build(){
+    DC_TRACE_SCOPE("DivePlan::build");
+    const Parameters& parameters = m_context->m_parameters;
     clear();
 
     // Set mode
@@ -63,9 +226,40 @@ void DivePlan::build(){
 
     // Add descending phase and initial deep stop
     addStep(0.0, 0.0, 0, Phase::GAS_SWITCH, activeMode);
-    addStep(0.0, maxDepth, maxDepth / g_parameters.m_maxDescentRate, Phase::DESCENDING, activeMode);
+    addStep(0.0, maxDepth, maxDepth / parameters.m_maxDescentRate, Phase::DESCENDING, activeMode);
     addStep(maxDepth, maxDepth, m_stopSteps.m_stopSteps[0].m_time, Phase::STOP, activeMode);
     
+    // Build the profile
+    processAscentStops(getAscentStops(maxDepth));
+
+    // Initialise the ppActual for Step 0
+    m_diveProfile[0].m_ppActual = m_initialPressure;
+
+    // New layout: nothing from a previous calculation can be reused
+    m_dirtyStage = PlanStage::TISSUES;
+    m_firstDirtyStep = 0;
+}
+
+// Direct ascent from the first stop step, which starts loaded with m_initialPressure
+void DivePlan::buildAscent(){
+    clear();
+
+    stepMode activeMode = (m_mode == diveMode::CC) ? stepMode::CC : stepMode::OC;
+    double depth = m_stopSteps.m_stopSteps[0].m_depth;
+
+    auto& startStep = addStep(depth, depth, 0, Phase::STOP, activeMode);
+    startStep.m_ppActual = m_initialPressure;
+
+    processAscentStops(getAscentStops(depth));
+
+    m_dirtyStage = PlanStage::TISSUES;
+    m_firstDirtyStep = 0;
+}
+
+// Depths of the ascent from maxDepth, deepest first: planned stops, deco stops and the surface
+std::vector<double> DivePlan::getAscentStops(double maxDepth){
+    const Parameters& parameters = m_context->m_parameters;
+
     // Collect all stops in one pass
     std::set<double> allStops = { maxDepth, 0.0 };
     
@@ -76,86 +270,154 @@ void DivePlan::build(){
     
     // Add required intermediate stops at multiples of m_depthIncrement
     for (double depth = calculateFirstStopDepth(maxDepth); 
-         depth >= g_parameters.m_lastStopDepth; 
-         depth -= g_parameters.m_depthIncrement) {
+         depth >= parameters.m_lastStopDepth; 
+         depth -= parameters.m_depthIncrement) {
         if (std::abs(depth - maxDepth) > 0.1) {  // Skip if already added deepest stop
             allStops.insert(depth);
         }
     }
     
-    // Add last stop depth if needed
-    allStops.insert(g_parameters.m_lastStopDepth);
+    // Add last stop depth if needed, unless starting above it
+    if (parameters.m_lastStopDepth < maxDepth) {
+        allStops.insert(parameters.m_lastStopDepth);
+    }
     
     // Convert to vector and sort descending
     std::vector<double> ascentStops(allStops.begin(), allStops.end());
     std::sort(ascentStops.begin(), ascentStops.end(), std::greater<double>());
-    
-    // Build the profile
-    processAscentStops(ascentStops);
+    return ascentStops;
+}
 
-    // Initialise the ppActual for Step 0
-    m_diveProfile[0].m_ppActual = m_initialPressure;
+// Charges the time since the previous lap to a pipeline stage
+class StageTimer {
+public:
+    explicit StageTimer(PlanCounters& counters) : m_counters(counters), m_lap(std::chrono::steady_clock::now()) {}
+
+    void lap(PipelineStage stage) {
+        auto now = std::chrono::steady_clock::now();
+        m_counters.m_stageTime[(int) stage] += std::chrono::duration<double, std::milli>(now - m_lap).count();
+        m_lap = now;
+    }
+
+    // Starts the next lap without charging anything, for time a nested timer has charged
+    void skip() { m_lap = std::chrono::steady_clock::now(); }
+
+private:
+    PlanCounters& m_counters;
+    std::chrono::steady_clock::time_point m_lap;
+};
+
+bool DivePlan::calculate(std::shared_ptr<const PlanContext> context) {
+    setContext(std::move(context));
+    return calculate();
 }
 
-void DivePlan::calculate() {
-    ErrorHandler::tryOperation([this]() {
+bool DivePlan::calculate() {
+    if (m_dirtyStage == PlanStage::NONE) {
+        return true;
+    }
+    DC_TRACE_SCOPE("DivePlan::calculate");
+
+    unsigned long long allocations = getThreadAllocationCount();
+    unsigned long long evaluations = getSchreinerStats().m_evaluations;
+
+    bool calculated = ErrorHandler::tryOperation([this]() {
+        StageTimer timer(m_counters);
+        if (m_dirtyStage == PlanStage::PROFILE) {
+            build();
+            timer.lap(PipelineStage::PROFILE);
+        }
+
         // Guard against inconsistent state
         if (m_diveProfile.empty()) {
             throw std::runtime_error("Cannot calculate with empty dive profile");
         }
 
-        m_firstDecoDepth = 0;
+        if (m_dirtyStage == PlanStage::CONSUMPTION) {
+            // Tissues, deco stops and the other variables are unaffected
+            updateConsumptions();
+            timer.lap(PipelineStage::CONSUMPTION);
+        }
+        else if (m_dirtyStage == PlanStage::VARIABLES) {
+            updateVariables(100); // GF 100 for ceiling
+            timer.lap(PipelineStage::VARIABLES);
+        }
+        else {
+            calculateSteps();
+            timer.skip();
+            updateCheckpoints();
+            m_firstDirtyStep = nbOfSteps();
+            timer.lap(PipelineStage::TISSUES);
+        }
 
-        // Update phase from first deco
-        updateStepsPhaseFromFirstDeco();
-        
-        // Apply gases
-        applyGases();
+        m_dirtyStage = PlanStage::NONE;
+    }, "DivePlan::calculate", "Calculation Error");
+
+    m_counters.m_calculations++;
+    m_counters.m_schreinerEvaluations += getSchreinerStats().m_evaluations - evaluations;
+    m_counters.m_allocations += getThreadAllocationCount() - allocations;
+    return calculated;
+}
 
-        // Initialise the gradient factor
-        applyGF();
+// Full pipeline over m_diveProfile, from the first dirty step
+void DivePlan::calculateSteps() {
+    DC_TRACE_SCOPE("DivePlan::calculateSteps");
+    StageTimer timer(m_counters);
+    m_firstDecoDepth = 0;
 
-        // Calculate ppInertGas for all steps
-        calculatePPInertGas();
+    // First pass is a direct ascent: no deco stop time yet
+    clearDecoSteps();
 
-        // Calculate ppInertGasMax for all steps
-        calculatePPInertGasMax();
+    // Update phase from first deco
+    updateStepsPhaseFromFirstDeco();
+    
+    // Apply gases
+    applyGases();
+    timer.lap(PipelineStage::GASES);
 
+    // Ambient pressures of every step, gas switches included, before loading the tissues
+    updatePpAmb();
 
-        // START LOGGING
-        printPlan(m_diveProfile);
-        int step = ;
-        m_diveProfile[step].printStepDetails(step);
+    // Initialise the gradient factor
+    applyGF();
 
-        // END LOGGING
+    // Calculate ppInertGas for the steps from the first dirty one. Further down, the
+    // loading stored on the steps comes from the deco pass of the previous calculation
+    calculatePPInertGas(std::max(1, std::min(m_firstDirtyStep, getFirstDecoStepIndex())));
 
+    // Calculate ppInertGasMax for all steps
+    calculatePPInertGasMax();
 
-        // Returns the first deco stop, required for applying the GF
-        setFirstDecoDepth();
 
-        // Apply the gradient factor to each step based on first deco stop determined
-        applyGF();
+    // Returns the first deco stop, required for applying the GF
+    setFirstDecoDepth();
 
-        // Calculate the pp_max values for each step adjusted for the GF
-        calculatePPInertGasMax();   
+    // Apply the gradient factor to each step based on first deco stop determined
+    applyGF();
 
-        // Update phase from first deco
-        updateStepsPhaseFromFirstDeco();
+    // Calculate the pp_max values for each step adjusted for the GF
+    calculatePPInertGasMax();   
+    timer.lap(PipelineStage::TISSUES);
 
-        // Re-apply gases after the first deco is found as the maxPPo2 will have changed for deco steps
-        applyGases();
+    // Update phase from first deco
+    updateStepsPhaseFromFirstDeco();
 
-        // Calculate deco steps
-        calculateDecoSteps();
+    // Re-apply gases after the first deco is found as the maxPPo2 will have changed for deco steps
+    applyGases();
+    timer.lap(PipelineStage::GASES);
 
-        // Update other variables
-        updateStepsPhaseFromFirstDeco();
-        updateVariables(100); // GF 100 for ceiling
-        updateTimeProfile();
-    }, "DivePlan::calculate", "Calculation Error");
+    // Calculate deco steps
+    calculateDecoSteps();
+    timer.lap(PipelineStage::DECO);
+
+    // Update other variables
+    updateStepsPhaseFromFirstDeco();
+    updateVariables(100); // GF 100 for ceiling
+    timer.lap(PipelineStage::VARIABLES);
 }
 
 void DivePlan::updateGasConsumption() {
+    DC_TRACE_SCOPE("DivePlan::updateGasConsumption");
     if (m_gasAvailable.empty() || m_diveProfile.empty()) {
         return;
     }
@@ -167,14 +429,8 @@ void DivePlan::updateGasConsumption() {
     
     // Calculate consumption for each step
     for (const auto& step : m_diveProfile) {
-        // Find the matching gas for this step
-        for (auto& gas : m_gasAvailable) {
-            if (std::abs(gas.m_gas.m_o2Percent - step.m_o2Percent) < 0.1 && 
-                std::abs(gas.m_gas.m_hePercent - step.m_hePercent) < 0.1) {
-                // Add this step's consumption to the gas
-                gas.m_consumption += step.m_stepConsumption;
-                break;
-            }
+        if (step.m_gasIndex >= 0) {
+            m_gasAvailable[step.m_gasIndex].m_consumption += step.m_stepConsumption;
         }
     }
     
@@ -192,30 +448,187 @@ void DivePlan::defineMission() {
     // TODO: Implement
 }
 
-void DivePlan::setMaxTime() {       
-    // TODO: Implement  
-}
-
 void DivePlan::optimiseDecoGas() {
     // TODO: Implement
 }
 
-double DivePlan::getTTSMax(){
-    // TODO: Implement
-    return 100.0;
+// Gas that can be breathed before reaching the reserve pressure, in surface liters
+static double getUsableGas(const GasAvailable& gas) {
+    return gas.m_nbTanks * gas.m_tankCapacity * (gas.m_fillingPressure - gas.m_reservePressure);
 }
 
+// Longest time at the first planned stop, in steps of m_timeIncrementMaxTime, with every gas
+// lasting to its reserve, and the TTS at that time
+std::pair<double, double> DivePlan::getMaxTimeAndTTS(){
+    DC_TRACE_SCOPE("DivePlan::getMaxTimeAndTTS");
+    calculate();
+
+    int stop = 1;
+    while (stop < nbOfSteps() && m_diveProfile[stop].m_phase != Phase::STOP) {
+        stop++;
+    }
+    if (stop >= nbOfSteps() || m_checkpoints.empty()) {
+        return {0.0, getTTS()};
+    }
+
+    const DiveStep& stopStep = m_diveProfile[stop];
+
+    // Gas used up to the first stop
+    std::vector<double> baseConsumption(m_gasAvailable.size(), 0.0);
+    for (int i = 0; i < stop; i++) {
+        int gas = m_diveProfile[i].m_gasIndex;
+        if (gas >= 0) baseConsumption[gas] += m_diveProfile[i].m_stepConsumption;
+    }
+
+    // Single level plan: stay longer from the checkpoint before the stop, then only simulate the ascent.
+    // Otherwise the later levels follow, so the whole plan is recalculated on a copy
+    bool singleLevel = (m_checkpoints.back().m_step == stop);
+
+    auto isEnoughGas = [&](double bottomTime, double& tts) {
+        if (!singleLevel) {
+            DivePlan trial(*this);
+            trial.editStopStepTime(0, bottomTime);
+            trial.calculate();
+            trial.updateGasConsumption();
+            tts = trial.getTTS();
+            return trial.enoughGasAvailable();
+        }
+
+        TissueState tissues;
+        SchreinerDecay scratch;
+        applySchreiner(m_checkpoints[stop - 1].m_ppActual, tissues, m_context->m_buhlmannModel.getDecay(bottomTime, scratch),
+                       stopStep.m_pAmbStartDepth, stopStep.m_pAmbEndDepth, stopStep.m_n2Percent, stopStep.m_hePercent);
+
+        DivePlan ascent(*this, stopStep.m_endDepth, tissues);
+        ascent.updateGasConsumption();
+        tts = ascent.getTTS();
+
+        // The ascent shares the gas inventory, in the same order
+        std::vector<double> consumption = baseConsumption;
+        if (stopStep.m_gasIndex >= 0) consumption[stopStep.m_gasIndex] += stopStep.m_ambConsumptionAtDepth * bottomTime;
+
+        for (size_t i = 0; i < m_gasAvailable.size(); i++) {
+            consumption[i] += ascent.m_gasAvailable[i].m_consumption;
+            if (consumption[i] > getUsableGas(m_gasAvailable[i])) return false;
+        }
+        return true;
+    };
+
+    // Gas use grows with the bottom time: double the number of increments, then bisect
+    double increment = m_context->m_parameters.m_timeIncrementMaxTime;
+    int low = 0;
+    int high = 1;
+    double lowTTS = 0.0;
+    double tts = 0.0;
+
+    isEnoughGas(0.0, lowTTS);
+    while (high * increment <= MAX_BOTTOM_TIME && isEnoughGas(high * increment, tts)) {
+        low = high;
+        lowTTS = tts;
+        high *= 2;
+    }
+    while (high - low > 1 && low * increment < MAX_BOTTOM_TIME) {
+        int middle = (low + high) / 2;
+        if (middle * increment <= MAX_BOTTOM_TIME && isEnoughGas(middle * increment, tts)) {
+            low = middle;
+            lowTTS = tts;
+        } else {
+            high = middle;
+        }
+    }
+
+    return {low * increment, lowTTS};
+}
+
+// Time to surface from the end of the last planned stop, ascent and deco included
 double DivePlan::getTTS(){
-    // TODO: Implement
-    return 100.0;
+    if (m_diveProfile.empty()) {
+        return 0.0;
+    }
+
+    return m_diveProfile[nbOfSteps() - 1].m_runTime - m_diveProfile[getBottomEndIndex()].m_runTime;
 }
 
-double DivePlan::getTTSDelta() {
-    // TODO: Implement
-    return 9.5;
+// Extra TTS if the bottom phase lasted incrementTime longer at its last depth
+double DivePlan::getTTSDelta(double incrementTime) {
+    calculate();
+    if (m_checkpoints.empty()) {
+        return 0.0;
+    }
+
+    double bottomEnd = m_checkpoints.back().m_runTime;
+    return getTTSIfAscentAt(bottomEnd + incrementTime) - getTTSIfAscentAt(bottomEnd);
+}
+
+// TTS of a direct ascent leaving at runTime, from the checkpoint just before it.
+// Past the bottom phase the diver is taken to stay at its last depth on the same gas
+double DivePlan::getTTSIfAscentAt(double runTime) {
+    calculate();
+    if (m_checkpoints.empty()) {
+        return 0.0;
+    }
+
+    auto next = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), runTime,
+                                 [](double time, const TissueCheckpoint& checkpoint) { return time < checkpoint.m_runTime; });
+    const TissueCheckpoint& from = (next == m_checkpoints.begin()) ? *next : *(next - 1);
+    bool pastBottom = (next == m_checkpoints.end());
+
+    // Step being run at runTime, and the depth reached in it
+    const DiveStep& step = m_diveProfile[pastBottom ? from.m_step : next->m_step];
+    double elapsed = std::max(0.0, runTime - from.m_runTime);
+    double startDepth = pastBottom ? step.m_endDepth : step.m_startDepth;
+    double depth = startDepth;
+    if (!pastBottom && step.m_time > 0) {
+        depth += (step.m_endDepth - step.m_startDepth) * std::min(elapsed / step.m_time, 1.0);
+    }
+
+    TissueState tissues = from.m_ppActual;
+    if (elapsed > 0) {
+        SchreinerDecay scratch;
+        applySchreiner(from.m_ppActual, tissues, m_context->m_buhlmannModel.getDecay(elapsed, scratch),
+                       getPressureFromDepth(startDepth), getPressureFromDepth(depth), step.m_n2Percent, step.m_hePercent);
+    }
+
+    if (depth <= 0.0) {
+        return 0.0;
+    }
+
+    DivePlan ascent(*this, depth, tissues);
+    return ascent.getTTS();
 }
 
-double DivePlan::getTP() {
+TimeProfile DivePlan::getTimeProfile() {
+    DC_TRACE_SCOPE("DivePlan::getTimeProfile");
+    calculate();
+    TimeProfile profile(m_diveProfile, m_context);
+    m_counters.m_timeProfileSamples += profile.size();
+    return profile;
+}
+
+TimeSeries DivePlan::getTimeSeries() {
+    return TimeSeries(getTimeProfile(), m_threadPool);
+}
+
+std::vector<CompartmentPP> DivePlan::getTissuesAfterSurfaceInterval(double interval) {
+    calculate();
+
+    // A single segment at constant pressure, whatever the length of the interval
+    SchreinerDecay scratch;
+    double pAmbSurface = getPressureFromDepth(0.0);
+    TissueTransform surface = TissueTransform::fromSegment(m_context->m_buhlmannModel.getDecay(std::max(0.0, interval), scratch),
+                                                           pAmbSurface, pAmbSurface, 100.0 - g_constants.m_oxygenInAir, 0.0);
+
+    TissueState tissues;
+    surface.apply((nbOfSteps() > 0) ? m_diveProfile[nbOfSteps() - 1].m_ppActual : m_initialPressure, tissues);
+
+    std::vector<CompartmentPP> compartments;
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        compartments.push_back(tissues.getCompartmentPP(j));
+    }
+    return compartments;
+}
+
+double DivePlan::getAP() {
     // TODO: Implement
     return 105.0;
 }
@@ -226,6 +639,47 @@ void DivePlan::clear(){
     m_diveProfile.clear();
 }
 
+// Every gas lasts to its reserve with the consumption from updateGasConsumption()
+bool DivePlan::enoughGasAvailable(){
+    for (const auto& gas : m_gasAvailable) {
+        if (gas.m_consumption > getUsableGas(gas)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Index in m_gasAvailable of the gas with this mix, -1 if none
+int DivePlan::findGasAvailable(double o2Percent, double hePercent) const {
+    for (int i = 0; i < (int) m_gasAvailable.size(); i++) {
+        if (std::abs(m_gasAvailable[i].m_gas.m_o2Percent - o2Percent) < 0.1 &&
+            std::abs(m_gasAvailable[i].m_gas.m_hePercent - hePercent) < 0.1) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Last STOP step below the surface, end of the bottom phase; 0 if there is none
+int DivePlan::getBottomEndIndex(){
+    for (int i = nbOfSteps() - 1; i > 0; i--) {
+        if (m_diveProfile[i].m_phase == Phase::STOP && m_diveProfile[i].m_endDepth > 0.0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Tissue loading at the end of every step of the bottom phase
+void DivePlan::updateCheckpoints(){
+    m_checkpoints.clear();
+
+    int bottomEnd = getBottomEndIndex();
+    for (int i = 0; i <= bottomEnd && i < nbOfSteps(); i++) {
+        m_checkpoints.push_back({i, m_diveProfile[i].m_runTime, m_diveProfile[i].m_ppActual});
+    }
+}
+
 void DivePlan::sortGases(){
     // Sort gases by increasing O2 then increasing He
     std::sort(m_gasAvailable.begin(), m_gasAvailable.end(), [](const GasAvailable& a, const GasAvailable& b) {
@@ -236,99 +690,65 @@ void DivePlan::sortGases(){
     });
 }
 
+// A step needs a switch when it breathes another mix than the previous one, within
+// the closed loop excepted where the mix follows the setpoint
+static bool needsGasSwitch(const DiveStep& previous, const DiveStep& step) {
+    return !(step.m_mode == stepMode::CC && previous.m_mode == stepMode::CC) &&
+           (std::abs(step.m_o2Percent - previous.m_o2Percent) > 0.1 ||
+            std::abs(step.m_hePercent - previous.m_hePercent) > 0.1);
+}
+
 void DivePlan::applyGases() {
+    DC_TRACE_SCOPE("DivePlan::applyGases");
     if (m_gasAvailable.empty()) {
         return;
     }
 
-    // Sort gases
-    sortGases();
+    // Air breathed by the surface steps
+    const Gas defaultAir(g_constants.m_oxygenInAir, 0.0, GasType::BOTTOM, GasStatus::ACTIVE, m_context->m_parameters);
+    const int airIndex = findGasAvailable(defaultAir.m_o2Percent, defaultAir.m_hePercent);
 
-    // Delete all GAS_SWITCH steps
-    std::vector<DiveStep> filteredSteps;
-    for (const auto& step : m_diveProfile) {
-        if (step.m_phase != Phase::GAS_SWITCH) {
-            filteredSteps.push_back(step);
-        }
-    }
-    m_diveProfile = filteredSteps;
+    // First pass, in place: the gas of every step, and whether the GAS_SWITCH steps
+    // already stand right before the steps which need one
+    int nbSwitches = 0;
+    int nbSwitchesNeeded = 0;
+    bool sameLayout = true;
+    const DiveStep* previous = nullptr;
 
-    // Create a new profile vector to hold steps with gas switches
-    std::vector<DiveStep> updatedProfile;
-    updatedProfile.reserve(m_diveProfile.size() * 2); // Reserve space for potential new steps
-    
-    // Track previous step's gas to detect changes
-    double prevO2Percent = g_constants.m_oxygenInAir;
-    double prevHePercent = 0.0;
-    stepMode prevMode = stepMode::CC;
-    
-    // Process each step and add gas switches in a single pass
     for (size_t i = 0; i < m_diveProfile.size(); ++i) {
         auto& step = m_diveProfile[i];
-        const Gas* selectedGas = nullptr;
+        if (step.m_phase == Phase::GAS_SWITCH) {
+            nbSwitches++;
+            continue;
+        }
+
+        int selectedIndex = -1;
         double maxDepth = std::max(step.m_startDepth, step.m_endDepth);
             
         // Check for surface step
         if(std::abs(step.m_startDepth) < 0.1 && std::abs(step.m_endDepth) < 0.1) {
-            Gas gas = Gas(); // Default to Air
-            selectedGas = &gas;
-            step.m_o2Percent = gas.m_o2Percent;
-            step.m_hePercent = gas.m_hePercent;
+            // Surface step breathes air
+            step.m_o2Percent = defaultAir.m_o2Percent;
+            step.m_hePercent = defaultAir.m_hePercent;
+            step.m_gasProperties = defaultAir.m_properties;
+            step.m_gasIndex = airIndex;
         }
         else {
-            // Determine the max ppO2 for this phase
-            double maxppO2 = 0.0;
-            switch(step.m_mode) {
-                case stepMode::OC:
-                    maxppO2 = g_parameters.m_PpO2Active;
-                    break;
-                case stepMode::BAILOUT:
-                    maxppO2 = g_parameters.m_PpO2Active;
-                    break;
-                case stepMode::DECO:
-                    maxppO2 = g_parameters.m_PpO2Deco;
-                    break;
-                case stepMode::CC:
-                    maxppO2 = g_parameters.m_maxPpO2Diluent;
-                    break;
-                default:
-                    maxppO2 = g_parameters.m_PpO2Active;
-                    break;
-            }
-            // Find the gas with the smallest MOD that can be used at this depth    
-            double smallestMOD = std::numeric_limits<double>::max();
-
-            for (const auto& gas : m_gasAvailable) {
-                double gasMOD = gas.m_gas.MOD(maxppO2);                
-
-                // Check if the gas MOD is smaller than the smallest MOD and greater than or equal to the current depth
-                if (gasMOD < smallestMOD && gasMOD >= maxDepth) {
-                    smallestMOD = gasMOD;
-                    selectedGas = &gas.m_gas;
-                }
-            }
-
-            // If no gas available, use the first gas available (which has the lowest O2 content)
-            if (selectedGas == nullptr) {
-                // Try to use the first available gas as a default
-                if (!m_gasAvailable.empty()) {
-                    selectedGas = &m_gasAvailable[0].m_gas;
-                } else {
-                    // If no gas available, use a default air
-                    static Gas defaultAir;
-                    selectedGas = &defaultAir;
-                }
-            }
+            selectedIndex = selectGas(step.m_mode, maxDepth);
+            const Gas* selectedGas = &m_gasAvailable[selectedIndex].m_gas;
+            step.m_gasIndex = selectedIndex;
 
             step.m_pAmbMax = std::max(getPressureFromDepth(step.m_startDepth), getPressureFromDepth(step.m_endDepth));
 
             if(step.m_mode == stepMode::CC) {
-                step.m_o2Percent = std::min(m_setPoints.getSetPointAtDepth(maxDepth, m_boosted) / step.m_pAmbMax * 100.0, 100.0);
+                step.m_o2Percent = std::min(m_setPoints.getSetPointAtDepth(maxDepth, m_boosted, m_context->m_parameters.m_maxPpO2Diluent) / step.m_pAmbMax * 100.0, 100.0);
                 step.m_hePercent = (100 - step.m_o2Percent) * selectedGas->m_hePercent / (100 - selectedGas->m_o2Percent);
+                step.m_gasProperties = GasProperties(step.m_o2Percent, step.m_hePercent, m_context->m_parameters);
             }
             else{
                 step.m_o2Percent = selectedGas->m_o2Percent;
                 step.m_hePercent = selectedGas->m_hePercent;
+                step.m_gasProperties = selectedGas->m_properties;
             }
         }
 
@@ -336,62 +756,273 @@ void DivePlan::applyGases() {
         step.m_n2Percent = 100.0 - step.m_o2Percent - step.m_hePercent;
         step.m_pO2Max = (step.m_o2Percent / 100.0) * step.m_pAmbMax;
 
-        // Check if we need to add a gas switch step
-        if (i > 0 && !(step.m_mode == stepMode::CC && prevMode == stepMode::CC) &&
-            (std::abs(step.m_o2Percent - prevO2Percent) > 0.1 || 
-             std::abs(step.m_hePercent - prevHePercent) > 0.1)) {
-            
-            // Find the corresponding GasAvailable object
-            for (auto& gasAvailable : m_gasAvailable) {
-                if (&gasAvailable.m_gas == selectedGas) {
-                    gasAvailable.m_switchDepth = step.m_startDepth;
-                    gasAvailable.m_switchPpO2 = step.m_pAmbMax * step.m_o2Percent / 100.0;
-                    break;
-                }
+        bool needsSwitch = (previous != nullptr) && needsGasSwitch(*previous, step);
+        if (needsSwitch) {
+            nbSwitchesNeeded++;
+
+            // Record the switch on the gas switched to; none for the air breathed at the surface
+            if (selectedIndex >= 0) {
+                m_gasAvailable[selectedIndex].m_switchDepth = step.m_startDepth;
+                m_gasAvailable[selectedIndex].m_switchPpO2 = step.m_pAmbMax * step.m_o2Percent / 100.0;
             }
+        }
 
-            // Create a gas switch step
-            DiveStep gasSwitch = step;
-            gasSwitch.m_endDepth = step.m_startDepth;
-            gasSwitch.m_time = 0.01; // Minimal time
-            gasSwitch.m_phase = Phase::GAS_SWITCH; 
-            
-            // Use the gas of the current step (the new gas being switched to)
-            
-            // Add the gas switch step to the updated profile
-            updatedProfile.push_back(gasSwitch);
+        bool hasSwitch = (i > 0) && (m_diveProfile[i - 1].m_phase == Phase::GAS_SWITCH);
+        sameLayout = sameLayout && (needsSwitch == hasSwitch);
+        previous = &step;
+    }
+
+    if (!sameLayout || nbSwitches != nbSwitchesNeeded) {
+        updateGasSwitchLayout();
+    }
+
+    // Each GAS_SWITCH step takes the mix of the step it leads to. One left identical to the
+    // previous calculation keeps its tissue loading
+    for (size_t i = 0; i + 1 < m_diveProfile.size(); ++i) {
+        DiveStep& gasSwitch = m_diveProfile[i];
+        if (gasSwitch.m_phase != Phase::GAS_SWITCH) continue;
+
+        const DiveStep& step = m_diveProfile[i + 1];
+        bool unchanged = std::abs(gasSwitch.m_startDepth - step.m_startDepth) < 0.1 &&
+                         std::abs(gasSwitch.m_o2Percent - step.m_o2Percent) < 0.1 &&
+                         std::abs(gasSwitch.m_hePercent - step.m_hePercent) < 0.1;
+        TissueState tissues = gasSwitch.m_ppActual;
+
+        gasSwitch = step;
+        gasSwitch.m_endDepth = step.m_startDepth;
+        gasSwitch.m_time = GAS_SWITCH_TIME; // Minimal time
+        gasSwitch.m_phase = Phase::GAS_SWITCH;
+        if (unchanged) {
+            gasSwitch.m_ppActual = tissues;
         }
-        
-        // Add the current step to the updated profile
-        updatedProfile.push_back(step);
-        
-        // Store current step's gas info for the next iteration
-        prevO2Percent = step.m_o2Percent;
-        prevHePercent = step.m_hePercent;
-        prevMode = step.m_mode;
     }
-    
-    // Replace the original profile with the updated one
-    m_diveProfile = std::move(updatedProfile);
+}
 
+// Moves the steps so that a GAS_SWITCH step stands right before each step which needs one,
+// and nowhere else. Switches still needed stay, the others are removed in a forward pass;
+// the new ones get a slot in a backward pass, filled by applyGases()
+void DivePlan::updateGasSwitchLayout() {
+    int size = nbOfSteps();
+    int kept = 0;
+    int lastStep = -1;
+
+    for (int read = 0; read < size; read++) {
+        const DiveStep& step = m_diveProfile[read];
+        if (step.m_phase == Phase::GAS_SWITCH) {
+            bool needed = lastStep >= 0 && read + 1 < size &&
+                          m_diveProfile[read + 1].m_phase != Phase::GAS_SWITCH &&
+                          needsGasSwitch(m_diveProfile[lastStep], m_diveProfile[read + 1]);
+            if (!needed) continue;
+        }
+        else {
+            lastStep = kept;
+        }
+
+        if (kept != read) {
+            m_diveProfile[kept] = m_diveProfile[read];
+        }
+        kept++;
+    }
+
+    int nbMissing = 0;
+    for (int i = 1; i < kept; i++) {
+        const DiveStep& step = m_diveProfile[i];
+        const DiveStep& before = m_diveProfile[i - 1];
+        if (step.m_phase != Phase::GAS_SWITCH && before.m_phase != Phase::GAS_SWITCH && needsGasSwitch(before, step)) {
+            nbMissing++;
+        }
+    }
+
+    m_diveProfile.resize(kept + nbMissing);
+    m_counters.m_gasSwitchInsertions += nbMissing;
+
+    int write = kept + nbMissing - 1;
+    for (int read = kept - 1; read >= 0 && write > read; read--) {
+        m_diveProfile[write--] = m_diveProfile[read];
+
+        const DiveStep& step = m_diveProfile[read];
+        if (read > 0 && step.m_phase != Phase::GAS_SWITCH && m_diveProfile[read - 1].m_phase != Phase::GAS_SWITCH &&
+            needsGasSwitch(m_diveProfile[read - 1], step)) {
+            m_diveProfile[write] = step;
+            m_diveProfile[write].m_phase = Phase::GAS_SWITCH;
+            write--;
+        }
+    }
+}
+
+void DivePlan::clearDecoSteps(){
+    for (auto& step : m_diveProfile) {
+        if (step.m_phase == Phase::DECO) {
+            step.m_time = 0.0;
+        }
+    }
 }
 
 void DivePlan::calculateDecoSteps(){
-    // TODO: Implement this
+    DC_TRACE_SCOPE("DivePlan::calculateDecoSteps");
+    clearDecoSteps();
+
+    // Gases were re-applied once the first deco stop was known: refresh pressures and limits
+    updatePpAmb();
+    calculatePPInertGasMax();
+
+    // Single pass: each stop is solved from the tissues reached at its start,
+    // then the tissues are carried forward with the solved time. Steps before the
+    // first deco stop kept their gas, and their loading from the first pass
+    int firstDecoStep = std::max(1, getFirstDecoStepIndex());
+
+    // Long profiles are loaded by the parallel scan with the stops cleared, which holds
+    // until a stop gets a different time; only the steps after it are carried forward here
+    bool loaded = isParallelScan(firstDecoStep);
+    if (loaded) {
+        calculatePPInertGasParallel(firstDecoStep);
+    }
 
-    for (int i = 0; i < nbOfSteps(); i++){
-        if (m_diveProfile[i].m_phase == Phase::DECO){
+    for (int i = firstDecoStep; i < nbOfSteps(); i++) {
+        if (m_diveProfile[i].m_phase == Phase::DECO) {
+            int nextStop = i + 1;
+            while (nextStop < nbOfSteps() &&
+                   m_diveProfile[nextStop].m_phase != Phase::DECO &&
+                   m_diveProfile[nextStop].m_phase != Phase::STOP) {
+                nextStop++;
+            }
 
-            if(m_diveProfile[i].m_endDepth <= m_firstDecoDepth){
-                m_diveProfile[i].m_time = (m_firstDecoDepth - m_diveProfile[i].m_endDepth)/ g_parameters.m_depthIncrement + 1;
+            if (nextStop < nbOfSteps() && nextStop - 1 > i) {
+                double stopTime = solveDecoStopTime(i, nextStop);
+                loaded = loaded && (stopTime == m_diveProfile[i].m_time);
+                m_diveProfile[i].m_time = stopTime;
             }
         }
+
+        if (!loaded) {
+            m_diveProfile[i].calculatePPInertGasForStep(m_diveProfile[i - 1], m_diveProfile[i].m_time, *m_context);
+        }
     }
 }
 
+// Composes the Schreiner updates of steps first..last into a single transform
+static TissueTransform getStepsTransform(const std::vector<DiveStep>& profile, int first, int last, const PlanContext& context) {
+    TissueTransform transform = TissueTransform::identity();
+    SchreinerDecay scratch;
+
+    for (int i = first; i <= last; i++) {
+        const DiveStep& step = profile[i];
+        transform = transform.then(TissueTransform::fromSegment(context.m_buhlmannModel.getDecay(step.m_time, scratch),
+                                                                step.m_pAmbStartDepth, step.m_pAmbEndDepth,
+                                                                step.m_n2Percent, step.m_hePercent));
+    }
+
+    return transform;
+}
+
+// Smallest t with a + b.exp(-k.t) <= limit, for one lane
+static double getLaneClearTime(double a, double b, double k, double limit) {
+    if (a + b <= limit) return 0.0;
+
+    // On-gassing lane, or limit below the pressure the lane tends to: never clears at this stop
+    if (b <= 0.0 || a >= limit) return MAX_DECO_STOP_TIME;
+
+    return std::min(-std::log((limit - a) / b) / k, MAX_DECO_STOP_TIME);
+}
+
+// Smallest t >= from with aN2 + bN2.exp(-kN2.t) + aHe + bHe.exp(-kHe.t) <= limit.
+// Two exponentials have no closed form: Newton, kept inside a bisection bracket
+static double getInertClearTime(double aN2, double bN2, double kN2, double aHe, double bHe, double kHe,
+                                double limit, double from) {
+    auto excess = [&](double t) {
+        return aN2 + aHe + bN2 * std::exp(-kN2 * t) + bHe * std::exp(-kHe * t) - limit;
+    };
+
+    if (excess(from) <= 0.0) return from;
+    if (aN2 + aHe >= limit) return MAX_DECO_STOP_TIME;
+
+    double low = from;
+    double high = from + 1.0;
+    while (excess(high) > 0.0) {
+        low = high;
+        high *= 2.0;
+        if (high >= MAX_DECO_STOP_TIME) return MAX_DECO_STOP_TIME;
+    }
+
+    double t = low;
+    for (int iteration = 0; iteration < 50 && high - low > 1e-6; iteration++) {
+        double value = excess(t);
+        if (value > 0.0) low = t;
+        else high = t;
+
+        double slope = -kN2 * bN2 * std::exp(-kN2 * t) - kHe * bHe * std::exp(-kHe * t);
+        double next = (slope < 0.0) ? t - value / slope : 0.5 * (low + high);
+        t = (next > low && next < high) ? next : 0.5 * (low + high);
+    }
+
+    return high;
+}
+
+// Minimum time at the DECO step 'stop' so the tissues arriving at 'nextStop' are within
+// its GF-adjusted limits, rounded up to the deco time increment
+double DivePlan::solveDecoStopTime(int stop, int nextStop) {
+    const PlanContext& context = *m_context;
+    const DiveStep& stopStep = m_diveProfile[stop];
+    const TissueState& start = m_diveProfile[stop - 1].m_ppActual;
+    const auto& limits = m_diveProfile[nextStop - 1].m_ppMaxAdjustedGF;
+    const auto& k = context.m_buhlmannModel.m_rateConstants;
+
+    TissueTransform ascent = getStepsTransform(m_diveProfile, stop + 1, nextStop - 1, context);
+
+    // At constant depth each lane relaxes as p(t) = pi + (p0 - pi).exp(-k.t),
+    // so on arrival at the next stop p = a + b.exp(-k.t)
+    double pInspired = stopStep.m_pAmbStartDepth - g_constants.m_pH2O;
+    std::array<double, TISSUE_LANES> a{};
+    std::array<double, TISSUE_LANES> b{};
+    for (int lane = 0; lane < TISSUE_LANES; lane++) {
+        double pi = pInspired * ((lane < COMPARTMENT_STRIDE) ? stopStep.m_n2Percent : stopStep.m_hePercent) / 100.0;
+        a[lane] = ascent.m_scale[lane] * pi + ascent.m_offset[lane];
+        b[lane] = ascent.m_scale[lane] * (start.m_lanes[lane] - pi);
+    }
+
+    double stopTime = 0.0;
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        int he = COMPARTMENT_STRIDE + j;
+        double t = std::max(getLaneClearTime(a[j], b[j], k[j], limits[j].m_pN2),
+                            getLaneClearTime(a[he], b[he], k[he], limits[j].m_pHe));
+        if (t < MAX_DECO_STOP_TIME) {
+            t = getInertClearTime(a[j], b[j], k[j], a[he], b[he], k[he], limits[j].m_pInert, t);
+        }
+        stopTime = std::max(stopTime, t);
+    }
+
+    auto breachesOnArrival = [&](double time) {
+        for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+            int he = COMPARTMENT_STRIDE + j;
+            double pN2 = a[j] + b[j] * std::exp(-k[j] * time);
+            double pHe = a[he] + b[he] * std::exp(-k[he] * time);
+            if (pN2 > limits[j].m_pN2 + 1e-9 || pHe > limits[j].m_pHe + 1e-9 || pN2 + pHe > limits[j].m_pInert + 1e-9) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Round up to the deco increment; step further only if an on-gassing lane still breaches
+    double increment = context.m_parameters.m_timeIncrementDeco;
+    double time = std::max(0.0, std::ceil(stopTime / increment - 1e-9)) * increment;
+    while (time < MAX_DECO_STOP_TIME && breachesOnArrival(time)) {
+        time += increment;
+    }
+
+    if (time >= MAX_DECO_STOP_TIME) {
+        ErrorHandler::logError("DivePlan", "Deco stop at " + std::to_string(stopStep.m_endDepth) +
+                               " m cannot clear the next stop with the selected gas", ErrorSeverity::WARNING);
+        time = MAX_DECO_STOP_TIME;
+    }
+
+    return time;
+}
+
 double DivePlan::calculateFirstStopDepth(double maxDepth){
-    double firstStopDepth = std::ceil(maxDepth / g_parameters.m_depthIncrement) * g_parameters.m_depthIncrement;
-    return (firstStopDepth > maxDepth) ? firstStopDepth - g_parameters.m_depthIncrement : firstStopDepth;
+    double depthIncrement = m_context->m_parameters.m_depthIncrement;
+    double firstStopDepth = std::ceil(maxDepth / depthIncrement) * depthIncrement;
+    return (firstStopDepth > maxDepth) ? firstStopDepth - depthIncrement : firstStopDepth;
 }
 
 void DivePlan::processAscentStops(const std::vector<double>& ascentStops){
@@ -402,7 +1033,7 @@ void DivePlan::processAscentStops(const std::vector<double>& ascentStops){
         double toDepth = ascentStops[i+1];
         
         // Add ascending step
-        double ascendTime = (fromDepth - toDepth) / g_parameters.m_maxAscentRate;
+        double ascendTime = (fromDepth - toDepth) / m_context->m_parameters.m_maxAscentRate;
         addStep(fromDepth, toDepth, ascendTime, Phase::ASCENDING, ascentMode);
         
         // Check if this is a planned stop
@@ -443,6 +1074,7 @@ DiveStep& DivePlan::addStep(double start_depth, double end_depth, double time, P
     step.m_phase = phase;
     step.m_mode = mode;
     m_diveProfile.push_back(step);
+    m_counters.m_stepsBuilt++;
     return m_diveProfile.back();
 }
 
@@ -454,6 +1086,7 @@ DiveStep& DivePlan::insertStep(int index, double start_depth, double end_depth,
     step.m_phase = phase;
     step.m_mode = mode;
     m_diveProfile.insert(m_diveProfile.begin() + index, step);
+    m_counters.m_stepsBuilt++;
     return m_diveProfile[index];
 }
 
@@ -465,33 +1098,101 @@ void DivePlan::deleteStep(int index) {
 
 // Decompression methods
 
-void DivePlan::calculatePPInertGas() {
-    for (int i = 1; i < (int) m_diveProfile.size(); i++) {
-        m_diveProfile[i].calculatePPInertGasForStep(m_diveProfile[i - 1], m_diveProfile[i].m_time);
+bool DivePlan::isParallelScan(int fromStep) const {
+    return m_threadPool != nullptr && m_threadPool->size() > 1 && (int) m_diveProfile.size() - fromStep >= PARALLEL_SCAN_MIN_STEPS;
+}
+
+void DivePlan::calculatePPInertGas(int fromStep) {
+    DC_TRACE_SCOPE("DivePlan::calculatePPInertGas");
+    if (isParallelScan(fromStep)) {
+        calculatePPInertGasParallel(fromStep);
+        return;
+    }
+
+    for (int i = fromStep; i < (int) m_diveProfile.size(); i++) {
+        m_diveProfile[i].calculatePPInertGasForStep(m_diveProfile[i - 1], m_diveProfile[i].m_time, *m_context);
+    }
+}
+
+// Each step is an affine map of the previous loading, so the profile is a prefix scan:
+// the blocks compose their steps in parallel, their start loadings are chained here,
+// then every block replays its own steps from its start loading in parallel
+void DivePlan::calculatePPInertGasParallel(int fromStep) {
+    DC_TRACE_SCOPE("DivePlan::calculatePPInertGasParallel");
+    const PlanContext& context = *m_context;
+    int nbSteps = (int) m_diveProfile.size() - fromStep;
+    int nbBlocks = std::max(1, std::min(4 * (int) m_threadPool->size(), nbSteps / 256));
+
+    auto blockBegin = [&](int block) { return fromStep + (int) ((long long) block * nbSteps / nbBlocks); };
+
+    // The Schreiner counters are per thread: the blocks run by pool workers are added to the
+    // plan's count here, calculate() takes the ones run on this thread
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<unsigned long long> workerEvaluations{0};
+    auto countEvaluations = [&](unsigned long long before) {
+        if (std::this_thread::get_id() != caller) {
+            workerEvaluations += getSchreinerStats().m_evaluations - before;
+        }
+    };
+
+    // The last block's transform is never needed
+    std::vector<TissueTransform> blockTransforms(nbBlocks - 1);
+    m_threadPool->parallelFor(blockTransforms.size(), [&](std::size_t block) {
+        DC_TRACE_SCOPE("DivePlan::calculatePPInertGasParallel block transform");
+        unsigned long long before = getSchreinerStats().m_evaluations;
+        blockTransforms[block] = getStepsTransform(m_diveProfile, blockBegin((int) block), blockBegin((int) block + 1) - 1, context);
+        countEvaluations(before);
+    });
+
+    std::vector<TissueState> blockStarts(nbBlocks);
+    blockStarts[0] = m_diveProfile[fromStep - 1].m_ppActual;
+    for (int block = 1; block < nbBlocks; block++) {
+        blockTransforms[block - 1].apply(blockStarts[block - 1], blockStarts[block]);
     }
+
+    m_threadPool->parallelFor(nbBlocks, [&](std::size_t block) {
+        DC_TRACE_SCOPE("DivePlan::calculatePPInertGasParallel block replay");
+        unsigned long long before = getSchreinerStats().m_evaluations;
+        SchreinerDecay scratch;
+        const TissueState* previous = &blockStarts[block];
+
+        for (int i = blockBegin((int) block); i < blockBegin((int) block + 1); i++) {
+            DiveStep& step = m_diveProfile[i];
+            applySchreiner(*previous, step.m_ppActual, context.m_buhlmannModel.getDecay(step.m_time, scratch),
+                           step.m_pAmbStartDepth, step.m_pAmbEndDepth, step.m_n2Percent, step.m_hePercent);
+            previous = &step.m_ppActual;
+        }
+        countEvaluations(before);
+    });
+
+    m_counters.m_schreinerEvaluations += workerEvaluations;
 }
 
 void DivePlan::calculatePPInertGasMax() {
+    DC_TRACE_SCOPE("DivePlan::calculatePPInertGasMax");
     double lastRatioN2He = 1.0;
 
     for (int i = 1; i < (int) m_diveProfile.size(); i++) {
-        m_diveProfile[i].calculatePPInertGasMaxForStep(lastRatioN2He);
+        m_diveProfile[i].calculatePPInertGasMaxForStep(lastRatioN2He, *m_context);
     }
 }
 
 void DivePlan::applyGF() {
+    DC_TRACE_SCOPE("DivePlan::applyGF");
     for (int i = 1; i < (int) m_diveProfile.size(); i++) {
-        m_diveProfile[i].m_gf = getGF(m_diveProfile[i].m_endDepth, m_firstDecoDepth);
+        m_diveProfile[i].m_gf = getGF(m_diveProfile[i].m_endDepth, m_firstDecoDepth, m_context->m_parameters);
     }
 }
 
 void DivePlan::setFirstDecoDepth() {
+    DC_TRACE_SCOPE("DivePlan::setFirstDecoDepth");
     int i = 1; // First Stop after the bottom phase
     bool breached = false;
 
     while (i < (int) m_diveProfile.size()) {
-        if (m_diveProfile[i].getIfBreachingDecoLimits()) {
-            std::cout << "Breached deco limits at depth " << m_diveProfile[i].m_endDepth << std::endl;
+        // Descent limits are taken at the surface pressure, they say nothing about the ascent
+        if (m_diveProfile[i].m_phase != Phase::DESCENDING && m_diveProfile[i].getIfBreachingDecoLimits()) {
+            DC_LOG_DEBUG("DivePlan", "Breached deco limits at depth " << m_diveProfile[i].m_endDepth);
             breached = true;
             break;
         }
@@ -516,19 +1217,35 @@ void DivePlan::setFirstDecoDepth() {
 // Update variable functions
 
 void DivePlan::updateStepsPhaseFromFirstDeco(){
+    stepMode ascentMode = (m_mode == diveMode::CC) ? (m_bailout ? stepMode::BAILOUT : stepMode::CC) : stepMode::OC;
     stepMode decoMode = (m_mode == diveMode::CC && !m_bailout) ? stepMode::CC : stepMode::DECO;
 
+    // Deeper than the first deco stop, steps go back to the ascent mode set by build(),
+    // so the result does not depend on the previous calculation
     for (int i = 0; i < (int) m_diveProfile.size(); i++) {
-        if (m_diveProfile[i].m_phase == Phase::DECO && m_diveProfile[i].m_startDepth <= m_firstDecoDepth) {
+        if (m_diveProfile[i].m_phase == Phase::DECO) {
+            stepMode mode = (m_diveProfile[i].m_startDepth <= m_firstDecoDepth) ? decoMode : ascentMode;
             int j = i;
             while (j < (int) m_diveProfile.size() && m_diveProfile[j].m_phase != Phase::STOP) {
-                m_diveProfile[j].m_mode = decoMode;
+                m_diveProfile[j].m_mode = mode;
                 j += 1;
             }
         }
     }
 }
 
+// First DECO step, with the gas switch in front of it if any; nbOfSteps() when there is none
+int DivePlan::getFirstDecoStepIndex(){
+    int index = 0;
+    while (index < nbOfSteps() && m_diveProfile[index].m_phase != Phase::DECO) {
+        index++;
+    }
+    while (index < nbOfSteps() && index > 0 && m_diveProfile[index - 1].m_phase == Phase::GAS_SWITCH) {
+        index--;
+    }
+    return index;
+}
+
 void DivePlan::updatePpAmb(){
     for (int i = 0; i < nbOfSteps(); i++){
         m_diveProfile[i].updatePAmb();
@@ -536,27 +1253,28 @@ void DivePlan::updatePpAmb(){
 }
 
 void DivePlan::updateCeiling(double GF){
+    m_counters.m_ceilingEvaluations += nbOfSteps();
     for (int i = 0; i < nbOfSteps(); i++){
-        m_diveProfile[i].updateCeiling(GF);
+        m_diveProfile[i].updateCeiling(GF, *m_context);
     }
 }
 
 void DivePlan::updateOxygenToxicity(){
     for (int i = 1; i < nbOfSteps(); i++) {
-        m_diveProfile[i].updateOxygenToxicity(&m_diveProfile[i - 1]);
+        m_diveProfile[i].updateOxygenToxicity(&m_diveProfile[i - 1], *m_context);
     }
 }
 
 void DivePlan::updateConsumptions(){
     for (int i = 0; i < nbOfSteps(); i++) {
-        m_diveProfile[i].updateConsumption();
+        m_diveProfile[i].updateConsumption(*m_context);
     }
 }
 
 void DivePlan::updateGFSurface(){
     
     for (int i = 0; i < (int) m_diveProfile.size(); i++) {
-        m_diveProfile[i].updateGFSurface(&m_diveProfile[nbOfSteps() - 1]);
+        m_diveProfile[i].updateGFSurface(&m_diveProfile[nbOfSteps() - 1], *m_context);
     }
 }
 
@@ -568,20 +1286,22 @@ void DivePlan::updateRunTimes(){
 }
 
 void DivePlan::updateVariables(double GF){
+    DC_TRACE_SCOPE("DivePlan::updateVariables");
     updateStepsPhaseFromFirstDeco();
+    m_counters.m_ceilingEvaluations += nbOfSteps();
 
     for (int i = 0; i < nbOfSteps(); i++){
         m_diveProfile[i].updatePAmb();
-        m_diveProfile[i].updateCeiling(GF);        
-        m_diveProfile[i].updateConsumption();
+        m_diveProfile[i].updateCeiling(GF, *m_context);        
+        m_diveProfile[i].updateConsumption(*m_context);
         m_diveProfile[i].m_pO2Max = m_diveProfile[i].m_pAmbMax * m_diveProfile[i].m_o2Percent / 100.0;
         m_diveProfile[i].m_n2Percent = 100.0 - m_diveProfile[i].m_o2Percent - m_diveProfile[i].m_hePercent;
-        m_diveProfile[i].updateGFSurface(&m_diveProfile[nbOfSteps() - 1]);
+        m_diveProfile[i].updateGFSurface(&m_diveProfile[nbOfSteps() - 1], *m_context);
         m_diveProfile[i].updateDensity();
         m_diveProfile[i].updateEND();
 
         if (i > 0){
-            m_diveProfile[i].updateOxygenToxicity(&m_diveProfile[i - 1]);
+            m_diveProfile[i].updateOxygenToxicity(&m_diveProfile[i - 1], *m_context);
             m_diveProfile[i].updateRunTime(&m_diveProfile[i - 1]);
         }
         else{
@@ -590,65 +1310,9 @@ void DivePlan::updateVariables(double GF){
     }
 }
 
-void DivePlan::updateTimeProfile(){
-
-    double time_increment = g_parameters.m_timeIncrementDeco;
-    int total_time_steps = (int) (m_diveProfile[nbOfSteps() - 1].m_runTime - m_diveProfile[0].m_runTime) / time_increment;
-
-    m_timeProfile.clear();
-    m_timeProfile.resize(total_time_steps);
-
-    int diveplan_index = 0;
-    int timeplan_index = 0;
-        
-    double run_time = m_diveProfile[0].m_runTime + time_increment;
-    double CNS_total_single_dive = 0;
-    double CNS_total_multiple_dives = 0;
-    double OTU_total = 0;
-
-    for (diveplan_index = 1; diveplan_index < nbOfSteps(); diveplan_index++){
-        double diveplan_start_time = m_diveProfile[diveplan_index].m_runTime - m_diveProfile[diveplan_index].m_time;
-        double diveplan_end_time = m_diveProfile[diveplan_index].m_runTime;
-
-        while (diveplan_start_time < run_time && run_time <= diveplan_end_time){
-            m_timeProfile[timeplan_index] = m_diveProfile[diveplan_index];
-            
-            // Only adjusts the values which are dependant on time
-            m_timeProfile[timeplan_index].m_time = time_increment;
-            m_timeProfile[timeplan_index].m_runTime = run_time;
-
-            m_timeProfile[timeplan_index].m_stepConsumption = m_timeProfile[timeplan_index].m_ambConsumptionAtDepth * time_increment;
-            
-            m_timeProfile[timeplan_index].m_cnsStepSingleDive = 
-                (m_timeProfile[timeplan_index].m_cnsMaxMinSingleDive != 0) ? 100 * time_increment / m_timeProfile[timeplan_index].m_cnsMaxMinSingleDive : 0;
-            CNS_total_single_dive += m_timeProfile[timeplan_index].m_cnsStepSingleDive;
-            m_timeProfile[timeplan_index].m_cnsTotalSingleDive = CNS_total_single_dive;
-
-            m_timeProfile[timeplan_index].m_cnsStepMultipleDives = 
-                (m_timeProfile[timeplan_index].m_cnsMaxMinMultipleDives != 0) ? 100 * time_increment / m_timeProfile[timeplan_index].m_cnsMaxMinMultipleDives : 0;
-            CNS_total_multiple_dives += m_timeProfile[timeplan_index].m_cnsStepMultipleDives;
-            m_timeProfile[timeplan_index].m_cnsTotalMultipleDives = CNS_total_multiple_dives;
-
-            m_timeProfile[timeplan_index].m_otuStep = time_increment * m_timeProfile[timeplan_index].m_otuPerMin;
-            OTU_total += m_timeProfile[timeplan_index].m_otuStep;
-            m_timeProfile[timeplan_index].m_otuTotal = OTU_total;
-
-            double pp_time = run_time - (m_diveProfile[diveplan_index].m_runTime - m_diveProfile[diveplan_index].m_time);
-            m_timeProfile[timeplan_index].calculatePPInertGasForStep(m_diveProfile[diveplan_index], pp_time);
-
-            timeplan_index++;
-            run_time += time_increment;
-        }
-    }
-
-    for (int i = 0; i < total_time_steps; i++){
-        m_timeProfile[i].updateGFSurface(&m_diveProfile[nbOfSteps() - 1]);
-    }
-}
-
 // Print-to-terminal functions
 
-void DivePlan::printPlan(std::vector<DiveStep> profile){
+void DivePlan::printPlan(const std::vector<DiveStep>& profile){
     printf("\nDIVE PROFILE\n\n");
  
     // Print the header
@@ -657,7 +1321,7 @@ void DivePlan::printPlan(std::vector<DiveStep> profile){
     printf("|  # |      |     (m)    |      (min)    |  max (bar)  |       |        |      (%%)        | (L/min)  /  (L) |(g/L)| non O2 / O2 | Dive | Day | min |\n");
     printf("----------------------------------------------------------------------------------------------------------------------------------------------------\n");
 
-    for (int i = 0; i < nbOfSteps(); i++){
+    for (int i = 0; i < (int) profile.size(); i++){
         printf("|%3i | ", i);
         if (profile[i].m_phase == Phase::DESCENDING)          printf("DESC | ");
         if (profile[i].m_phase == Phase::GAS_SWITCH)          printf("GAS  | ");
@@ -681,6 +1345,16 @@ void DivePlan::printPlan(std::vector<DiveStep> profile){
     printf("----------------------------------------------------------------------------------------------------------------------------------------------------\n\n");
 }
 
+void DivePlan::printSummary(){
+    if (m_diveProfile.empty()) {
+        return;
+    }
+
+    const DiveStep& lastStep = m_diveProfile[nbOfSteps() - 1];
+    printf("Run time: %5.1f min | CNS: %5.1f%% | OTU: %5.1f\n",
+        lastStep.m_runTime, lastStep.m_cnsTotalSingleDive, lastStep.m_otuTotal);
+}
+
 void DivePlan::printCompartmentDetails(int compartment){
     printf("| Step | Comp | Depth | P_amb |   GF  | pp_GF_n2 | pp_n2 | pp_GF_he | pp_he | pp_GF_inert | pp_inert |\n");
 
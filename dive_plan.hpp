@@ -1,6 +1,7 @@
 #ifndef DIVE_PLAN_HPP
 #define DIVE_PLAN_HPP
 
+#include <array>
 #include <vector>
 #include <memory>
 #include <set>
@@ -14,9 +15,71 @@
 #include "gaslist.hpp"
 #include "set_points.hpp"
 #include "oxygen_toxicity.hpp"
+#include "plan_context.hpp"
+#include "time_profile.hpp"
+#include "time_series.hpp"
 
 namespace DiveComputer {
 
+// Upper bound of a single deco stop, only reached when the stop gas cannot clear the next stop
+const double MAX_DECO_STOP_TIME = 999.0;
+
+// Search bound of DivePlan::getMaxTimeAndTTS, in minutes
+const double MAX_BOTTOM_TIME = 999.0;
+
+// Profiles with at least this many steps to load are scanned in parallel when a thread pool is set
+const int PARALLEL_SCAN_MIN_STEPS = 2048;
+
+class ThreadPool;
+
+// Tissue loading at the end of a step of the bottom phase, start point of what-if ascents
+struct TissueCheckpoint {
+    int         m_step;       // index in DivePlan::m_diveProfile
+    double      m_runTime;
+    TissueState m_ppActual;
+};
+
+// Stages of DivePlan::calculate(), cheapest first; a dirty stage also re-runs every cheaper one.
+// Inputs feed them as follows:
+//   CONSUMPTION  SAC rates
+//   VARIABLES    minimum temperature, default END, O2 narcotic
+//   TISSUES      stop times, gases, setpoints, boost, GF, ppO2 limits, deco time increment
+//   PROFILE      stop depths, mode, bailout, ascent and descent rates, depth increment, last stop depth
+enum class PlanStage {
+    NONE,
+    CONSUMPTION,
+    VARIABLES,
+    TISSUES,
+    PROFILE
+};
+
+// Parts of the calculation pipeline, to break down where calculate() spends its time
+enum class PipelineStage {
+    PROFILE,        // build()
+    GASES,          // gas assignment, gas switch insertion, phases
+    TISSUES,        // ambient pressures, GF, tissue loading and limits, checkpoints
+    DECO,           // deco stop times
+    VARIABLES,      // ceilings, ppO2, END, densities and the other per-step variables
+    CONSUMPTION     // gas consumption only
+};
+
+const int NUM_PIPELINE_STAGES = 6;
+
+// Work done by a plan since it was created, to tell whether a slow plan is slow because of
+// its step count or its time profile resolution. Always on: a few additions per calculation
+struct PlanCounters {
+    unsigned long long m_calculations{0};           // calculate() calls with something to do
+    unsigned long long m_stepsBuilt{0};             // steps laid out by build()
+    unsigned long long m_gasSwitchInsertions{0};    // GAS_SWITCH steps inserted by applyGases()
+    unsigned long long m_schreinerEvaluations{0};   // during calculate(), thread pool workers included
+    unsigned long long m_ceilingEvaluations{0};
+    unsigned long long m_allocations{0};            // during calculate(), on the calling thread; 0 unless counted (perf_counters.hpp)
+    unsigned long long m_timeProfileSamples{0};     // samples of the profiles from getTimeProfile()
+
+    // Time spent in calculate() in ms, by pipeline stage (PipelineStage index)
+    std::array<double, NUM_PIPELINE_STAGES> m_stageTime{};
+};
+
 // Create a new struct for gas tracking
 struct GasAvailable {
     Gas    m_gas;
@@ -34,29 +97,63 @@ struct GasAvailable {
                                 m_consumption(0.0), m_endPressure(200.0) {}
 };
 
+// Gas of the inventory breathable down to m_MOD in one step mode
+struct GasChoice {
+    double m_MOD;
+    int    m_gasIndex;
+};
+
+// Step modes, the number of gas selection tables
+const int NUM_STEP_MODES = 4;
+
 // Dive profile management class
 class DivePlan {
 public:
     DivePlan(double depth, double time, diveMode mode, int diveNumber, std::vector<CompartmentPP> initialPressure);
+    DivePlan(double depth, double time, diveMode mode, int diveNumber, std::vector<CompartmentPP> initialPressure,
+             std::shared_ptr<const PlanContext> context, bool bailout = false);
     ~DivePlan() = default;
 
+    // Settings snapshot used by build() and calculate(); replaced, never modified in place.
+    // The differences with the previous snapshot are invalidated accordingly
+    void setContext(std::shared_ptr<const PlanContext> context);
+    const PlanContext& getContext() const { return *m_context; }
+
+    // calculate() only re-runs the stages invalidated since the last call, and keeps the
+    // tissue loading of the steps before fromStep. Direct edits of the public members
+    // (steps, setpoints, boost) must be reported here
+    void invalidate(PlanStage stage, int fromStep = 0);
+    bool isDirty() const { return m_dirtyStage != PlanStage::NONE; }
+
+    // Change the time of a planned stop without rebuilding the profile
+    void editStopStepTime(int stopStep, double time);
+
+    // Pool used to load the tissues of long profiles (imported logs, expedition series);
+    // not owned, nullptr keeps every calculation on the calling thread
+    void setThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
+    PlanCounters getCounters() const { return m_counters; }
+    void resetCounters() { m_counters = PlanCounters(); }
+
     StopSteps m_stopSteps;
     diveMode  m_mode;
 
-    bool m_bailout;
+    bool m_bailout{false};
     int  m_diveNumber;
-    bool m_boosted;
+    bool m_boosted{false};
     SetPoints m_setPoints;
 
-    std::vector<CompartmentPP> m_initialPressure;
+    TissueState m_initialPressure;
     std::vector<DiveStep> m_diveProfile;
-    std::vector<DiveStep> m_timeProfile;
     std::vector<GasAvailable> m_gasAvailable;
 
     // Core methods
     void loadAvailableGases();
     void build();
-    void calculate();
+    void build(std::shared_ptr<const PlanContext> context);
+    // False if the calculation failed: the error is logged and the plan stays dirty
+    bool calculate();
+    bool calculate(std::shared_ptr<const PlanContext> context);
     void calculateOtherVariables();
     void updateGasConsumption();
     int  nbOfSteps();
@@ -67,35 +164,75 @@ public:
     void   optimiseDecoGas();
     double getTTS();
     double getTTSDelta(double incrementTime);
+    double getTTSIfAscentAt(double runTime);
+
+    // Samples every deco time increment, generated as they are read; valid until the plan changes
+    TimeProfile getTimeProfile();
+
+    // Compact copy of every sample, which outlives the plan's later changes
+    TimeSeries getTimeSeries();
     double getAP();
 
+    // Tissue loading after breathing air at the surface for interval minutes, as the initial pressure of a repetitive dive
+    std::vector<CompartmentPP> getTissuesAfterSurfaceInterval(double interval);
+
     // Print-to-terminal functions
-    void printPlan(std::vector<DiveStep> profile);
+    void printPlan(const std::vector<DiveStep>& profile);
     void printCompartmentDetails(int compartment);
     void printGF();
     void printO2Exposure();
     void printSummary();
 private:
+    std::shared_ptr<const PlanContext> m_context;
     double m_firstDecoDepth;
 
+    PlanStage m_dirtyStage{PlanStage::PROFILE};
+    int       m_firstDirtyStep{0};
+
+    ThreadPool* m_threadPool{nullptr};
+
+    PlanCounters m_counters;
+
+    // Per step mode, the gases by increasing MOD at the mode's max ppO2, one per MOD.
+    // Rebuilt when the gases or the ppO2 limits change
+    std::array<std::vector<GasChoice>, NUM_STEP_MODES> m_gasChoices;
+
+    // Bottom phase checkpoints, refreshed whenever the tissues are
+    std::vector<TissueCheckpoint> m_checkpoints;
+
+    // What-if plan: direct ascent from depth with the given loading, with the settings and gases of plan
+    DivePlan(const DivePlan& plan, double depth, const TissueState& tissues);
+
     // Helper methods
     void   clear();
+    void   buildAscent();
+    std::vector<double> getAscentStops(double maxDepth);
+    void   calculateSteps();
+    void   updateCheckpoints();
+    int    getBottomEndIndex();
+    int    findGasAvailable(double o2Percent, double hePercent) const;
     void   clearDecoSteps();
     void   sortGases();
     void   applyGases();
+    void   updateGasSwitchLayout();
+    void   updateGasProperties();
+    void   updateGasChoices();
+    int    selectGas(stepMode mode, double depth) const;
     void   calculateDecoSteps();
-    bool   getIfBreachingDecoLimitsInRange(int deco, int next_deco);
-    void   calculatePPInertGasInRange(int deco, int next_deco);
+    double solveDecoStopTime(int stop, int nextStop);
     double calculateFirstStopDepth(double maxDepth);
     void   processAscentStops(const std::vector<double>& ascentStops);
     bool   enoughGasAvailable();
+    int    getFirstDecoStepIndex();
 
     DiveStep& addStep(double start_depth, double end_depth, double time, Phase phase, stepMode mode);
     DiveStep& insertStep(int index, double start_depth, double end_depth, double time, Phase phase, stepMode mode);
     void deleteStep(int index);
 
     // Decompression methods
-    void calculatePPInertGas();
+    void calculatePPInertGas(int fromStep = 1);
+    void calculatePPInertGasParallel(int fromStep);
+    bool isParallelScan(int fromStep) const;
     void calculatePPInertGasMax();
     void applyGF();
     void setFirstDecoDepth();
@@ -109,7 +246,6 @@ private:
     void updateGFSurface();
     void updateRunTimes();
     void updateVariables(double GF);
-    void updateTimeProfile();
 };
 
 } // namespace DiveComputer
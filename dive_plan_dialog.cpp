@@ -1,5 +1,5 @@
 #include "dive_plan_dialog.hpp"
-#include "error_handler.hpp"
+#include "error_dialog.hpp"
 
 namespace DiveComputer {
 
@@ -74,13 +74,13 @@ void DivePlanDialog::validateInputs() {
     
     // Use new validator for depth
     if (depthValid) {
-        depthValid = ErrorHandler::validateNumericInput(
+        depthValid = ErrorDialog::validateNumericInput(
             depthEdit->text(), depth, 0.1, 300.0, "Depth", false);
     }
     
     // Use new validator for time
     if (timeValid) {
-        timeValid = ErrorHandler::validateNumericInput(
+        timeValid = ErrorDialog::validateNumericInput(
             bottomTimeEdit->text(), time, 0.1, 1000.0, "Bottom Time", false);
     }
     
@@ -3,7 +3,7 @@
 
 #include "qtheaders.hpp"
 #include "enum.hpp"
-#include "error_handler.hpp"
+#include "error_dialog.hpp"
 
 namespace DiveComputer {
 
@@ -32,11 +32,11 @@ DivePlanWindow::DivePlanWindow(double depth, double bottomTime, diveMode mode, Q
         if (m_divePlan->m_setPoints.nbOfSetPoints() == 0) {
             m_divePlan->m_setPoints.addSetPoint(0.0, 0.7);
             m_divePlan->m_setPoints.saveSetPointsToFile();
+            g_setPoints = m_divePlan->m_setPoints;
         }
     }
-    
-    // Make sure the setpoints are sorted
-    m_divePlan->m_setPoints.sortSetPoints();
+
+    m_divePlan->invalidate(PlanStage::TISSUES);
     m_divePlan->calculate();
     
     // Add a test shortcut for manual menu refresh (for debugging)
@@ -49,24 +49,14 @@ DivePlanWindow::DivePlanWindow(double depth, double bottomTime, diveMode mode, Q
     // Set up UI
     setupUI();
     
-    QElapsedTimer timer;
-    timer.start();
-    
     // Initial refresh of tables
-    refreshStopStepsTable();
-    qDebug() << "Initial refreshStopStepsTable() took" << timer.elapsed() << "ms";
-    
-    timer.restart();
-    refreshSetpointsTable();
-    qDebug() << "Initial refreshSetpointsTable() took" << timer.elapsed() << "ms";
-    
-    timer.restart();
-    refreshDivePlanTable();
-    qDebug() << "Initial refreshDivePlanTable() took" << timer.elapsed() << "ms";
-    
-    timer.restart();
-    refreshGasesTable();
-    qDebug() << "Initial refreshGasesTable() took" << timer.elapsed() << "ms";
+    {
+        DC_TRACE_SCOPE("DivePlanWindow initial tables");
+        refreshStopStepsTable();
+        refreshSetpointsTable();
+        refreshDivePlanTable();
+        refreshGasesTable();
+    }
     
     // Update setpoint visibility based on current mode
     updateSetpointVisibility();
@@ -273,18 +263,13 @@ void DivePlanWindow::rebuildDivePlan() {
     
     isRebuilding = true;
     
-    QElapsedTimer timer;
-    timer.start();
-    
-    // PERFORM THE REBUILD
-    m_divePlan->build();
-    qDebug() << "build() took" << timer.elapsed() << "ms";
+    DC_TRACE_SCOPE("DivePlanWindow::rebuildDivePlan");
     
+    // PERFORM THE REBUILD with a fresh snapshot of the parameters edited in the other windows
+    m_divePlan->build(PlanContext::fromGlobals(m_divePlan->m_setPoints));
     
     // Refresh the stopstep table
-    timer.restart();
     refreshStopStepsTable();
-    qDebug() << "refreshStopStepsTable() took" << timer.elapsed() << "ms";
 
     m_tableDirty = true;
     isRebuilding = false;
@@ -299,34 +284,52 @@ void DivePlanWindow::refreshDivePlan() {
     
     isRefreshing = true;
    
-    QElapsedTimer timer;
-    timer.start();
+    // Spans for the engine calls are recorded inside DivePlan
+    DC_TRACE_SCOPE("DivePlanWindow::refreshDivePlan");
     
-    // Log the execution times for optimization purposes
-    m_divePlan->calculate();
-    qDebug() << "calculate() took" << timer.elapsed() << "ms";
-    
-    timer.restart();
+    m_divePlan->calculate(PlanContext::fromGlobals(m_divePlan->m_setPoints));
     m_divePlan->updateGasConsumption();
-    qDebug() << "updateGasConsumption() took" << timer.elapsed() << "ms";
     refreshGasesTable();
     
-    timer.restart();
     // Check if the dive plan table is visible by checking its height
     bool isTableVisible = divePlanTable && divePlanTable->isVisible() && divePlanTable->height() > 0;
     
     if (isTableVisible) {
         refreshDivePlanTable();
-        qDebug() << "refreshDivePlanTable() took" << timer.elapsed() << "ms";
     } else {
         // Mark the table as dirty so it will be refreshed when made visible
         m_tableDirty = true;
         qDebug() << "DivePlanTable refresh deferred (not visible)";
     }
 
+    updatePerformanceStatus();
     isRefreshing = false;
 }
 
+// Work done by the engine since the last update, to relate lag to the size of the plan
+void DivePlanWindow::updatePerformanceStatus() {
+    PlanCounters counters = m_divePlan->getCounters();
+
+    double time = 0.0;
+    for (int stage = 0; stage < NUM_PIPELINE_STAGES; stage++) {
+        time += counters.m_stageTime[stage] - m_statusCounters.m_stageTime[stage];
+    }
+
+    QString message = QString("%1 steps | calculate %2 ms | %3 Schreiner, %4 ceilings | %5 gas switches inserted")
+                          .arg(m_divePlan->nbOfSteps())
+                          .arg(time, 0, 'f', 2)
+                          .arg(counters.m_schreinerEvaluations - m_statusCounters.m_schreinerEvaluations)
+                          .arg(counters.m_ceilingEvaluations - m_statusCounters.m_ceilingEvaluations)
+                          .arg(counters.m_gasSwitchInsertions - m_statusCounters.m_gasSwitchInsertions);
+    unsigned long long samples = counters.m_timeProfileSamples - m_statusCounters.m_timeProfileSamples;
+    if (samples > 0) {
+        message += QString(" | %1 time profile samples").arg(samples);
+    }
+
+    statusBar()->showMessage(message);
+    m_statusCounters = counters;
+}
+
 QString DivePlanWindow::getPhaseString(Phase phase)
 {
     return QString::fromStdString(getPhaseIcon(phase));
@@ -974,7 +977,7 @@ void DivePlanWindow::setMaxTime(){
         }
     }
     m_divePlan->m_diveProfile[firstStopIndex].m_time = result.first;
-    m_divePlan->calculate();
+    m_divePlan->invalidate(PlanStage::TISSUES, firstStopIndex);
     refreshDivePlan();
     refreshStopStepsTable();
 }
@@ -1052,8 +1055,7 @@ void DivePlanWindow::onSplitterMoved(int /*pos*/, int index) {
 }
 
 void DivePlanWindow::ccModeActivated() {
-    QElapsedTimer timer;
-    timer.start();
+    DC_TRACE_SCOPE("DivePlanWindow CC mode");
     
     // Set CC mode
     m_divePlan->m_mode = diveMode::CC;
@@ -1068,8 +1070,6 @@ void DivePlanWindow::ccModeActivated() {
     rebuildDivePlan();
     refreshDivePlan();
     
-    qDebug() << "CC Mode switch took" << timer.elapsed() << "ms";
-    
     // Allow UI to process events after the edit
     QApplication::processEvents();
 }
@@ -1,13 +1,14 @@
 #ifndef DIVE_PLAN_GUI_HPP
 #define DIVE_PLAN_GUI_HPP
 
-#include <QElapsedTimer>
 #include "qtheaders.hpp"
 #include "dive_plan.hpp"
 #include "parameters.hpp"
 #include "enum.hpp"
 #include "global.hpp"
 #include "ui_utils.hpp"
+#include "error_dialog.hpp"
+#include "trace.hpp"
 
 // Forward declaration of MainWindow class
 namespace DiveComputer { class MainWindow; }
@@ -158,6 +159,9 @@ private:
     bool m_tableDirty = false;
     bool m_isUpdating = false;
 
+    // Plan counters when the status bar was last updated
+    PlanCounters m_statusCounters;
+
     // Store original column widths for proportional resizing
     QVector<int> m_originalColumnWidths;
     int m_totalOriginalWidth = 0;
@@ -184,6 +188,7 @@ private:
     void rebuildDivePlan();
     void refreshDivePlan();
     void highlightWarningCells();
+    void updatePerformanceStatus();
     void setupGasesTable();
     void refreshGasesTable();
     
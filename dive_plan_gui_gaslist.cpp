@@ -59,6 +59,7 @@ void DivePlanWindow::setupGasesTable() {
 }
 
 void DivePlanWindow::refreshGasesTable() {
+    DC_TRACE_SCOPE("DivePlanWindow::refreshGasesTable");
     static bool isRefreshing = false;
     if (isRefreshing) return;
     
@@ -310,7 +311,7 @@ void DivePlanWindow::gasTableCellChanged(int row, int column) {
         }
         
         // Validate the input
-        if (ErrorHandler::validateNumericInput(item->text(), newValue, minValue, maxValue, fieldName)) {
+        if (ErrorDialog::validateNumericInput(item->text(), newValue, minValue, maxValue, fieldName)) {
             // Get the original index of the gas from the O2 column's user data
             QTableWidgetItem* o2Item = gasesTable->item(row, GAS_COL_O2);
             if (!o2Item) return;
@@ -345,7 +346,7 @@ void DivePlanWindow::gasTableCellChanged(int row, int column) {
                         QTableWidgetItem* endItem = gasesTable->item(row, GAS_COL_END_PRESSURE);
                         if (endItem) {
                             double endPressure = 0.0;
-                            if (ErrorHandler::validateNumericInput(endItem->text(), endPressure, 0.0, 1000.0, "End Pressure", false)) {
+                            if (ErrorDialog::validateNumericInput(endItem->text(), endPressure, 0.0, 1000.0, "End Pressure", false)) {
                                 if (endPressure <= newValue && endPressure > 0) {
                                     endItem->setBackground(QBrush(QColor(255, 200, 200)));
                                 } else if (endPressure > newValue) {
@@ -26,8 +26,7 @@ void DivePlanWindow::setupMenu() {
     m_bailoutAction->setChecked(m_divePlan->m_bailout);
     m_bailoutAction->setVisible(m_divePlan->m_mode == diveMode::CC);
     connect(m_bailoutAction, &QAction::triggered, [this]() {
-        QElapsedTimer timer;
-        timer.start();
+        DC_TRACE_SCOPE("DivePlanWindow bailout toggle");
         
         // Toggle bailout mode
         m_divePlan->m_bailout = m_bailoutAction->isChecked();
@@ -36,8 +35,6 @@ void DivePlanWindow::setupMenu() {
         rebuildDivePlan();
         refreshDivePlan();
         
-        qDebug() << "Bailout toggle took" << timer.elapsed() << "ms";
-        
         // Allow UI to process events after the edit
         QApplication::processEvents();
     });
@@ -49,17 +46,15 @@ void DivePlanWindow::setupMenu() {
     m_gfBoostedAction->setChecked(m_divePlan->m_boosted);
     m_gfBoostedAction->setVisible(m_divePlan->m_mode == diveMode::CC);
     connect(m_gfBoostedAction, &QAction::triggered, [this]() {
-        QElapsedTimer timer;
-        timer.start();
+        DC_TRACE_SCOPE("DivePlanWindow boost toggle");
         
         // Toggle SP Boosted mode
         m_divePlan->m_boosted = m_gfBoostedAction->isChecked();
         
         // Update the display - only needs calculate() which is called by refreshDivePlan()
+        m_divePlan->invalidate(PlanStage::TISSUES);
         refreshDivePlan();
         
-        qDebug() << "SP Boosted toggle took" << timer.elapsed() << "ms";
-        
         // Allow UI to process events after the edit
         QApplication::processEvents();
     });
@@ -70,8 +65,7 @@ void DivePlanWindow::setupMenu() {
     m_ocModeAction->setCheckable(true);
     m_ocModeAction->setChecked(m_divePlan->m_mode == diveMode::OC);
     connect(m_ocModeAction, &QAction::triggered, [this]() {
-        QElapsedTimer timer;
-        timer.start();
+        DC_TRACE_SCOPE("DivePlanWindow OC mode");
         
         // Set OC mode
         m_divePlan->m_mode = diveMode::OC;
@@ -86,8 +80,6 @@ void DivePlanWindow::setupMenu() {
         rebuildDivePlan();
         refreshDivePlan();
         
-        qDebug() << "OC Mode switch took" << timer.elapsed() << "ms";
-        
         // Allow UI to process events after the edit
         QApplication::processEvents();
     });
@@ -137,8 +129,7 @@ void DivePlanWindow::updateMenuState() {
 }
 
 void DivePlanWindow::diveModeChanged(int index) {
-    QElapsedTimer timer;
-    timer.start();
+    DC_TRACE_SCOPE("DivePlanWindow::diveModeChanged");
     
     // Update dive plan mode
     diveMode newMode = static_cast<diveMode>(index);
@@ -154,8 +145,6 @@ void DivePlanWindow::diveModeChanged(int index) {
     rebuildDivePlan();
     refreshDivePlan();
     
-    qDebug() << "diveModeChanged() took" << timer.elapsed() << "ms";
-
     // Allow UI to process events after the edit
     QApplication::processEvents();
 }
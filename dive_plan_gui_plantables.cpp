@@ -71,6 +71,9 @@ void DivePlanWindow::setupDivePlanTable() {
 }
 
 void DivePlanWindow::refreshDivePlanTable() {
+    DC_TRACE_SCOPE("DivePlanWindow::refreshDivePlanTable");
+
+    // No-op unless something was invalidated since refreshDivePlan()
     m_divePlan->calculate();
 
     // Use the TableHelper for safe update
@@ -288,13 +291,9 @@ void DivePlanWindow::divePlanCellChanged(int row, int column)
                 for (int i = 0; i < m_divePlan->m_stopSteps.nbOfStopSteps(); ++i) {
                     // Match by depth to find the corresponding stop step
                     if (std::abs(m_divePlan->m_stopSteps.m_stopSteps[i].m_depth - step.m_startDepth) < 0.1) {
-                        // Update the stop step time
-                        m_divePlan->m_stopSteps.editStopStep(i, 
-                                                         m_divePlan->m_stopSteps.m_stopSteps[i].m_depth, 
-                                                         newTime);
-                        
-                        // Rebuild everything
-                        rebuildDivePlan();
+                        // Update the stop step time, the profile layout is unchanged
+                        m_divePlan->editStopStepTime(i, newTime);
+                        refreshStopStepsTable();
                         refreshDivePlan();
                         
                         // Allow UI to process events
@@ -14,8 +14,7 @@ void DivePlanWindow::setpointCellChanged(int row, int column) {
         double value = item->text().toDouble(&ok);
         
         if (ok) {
-            QElapsedTimer timer;
-            timer.start();
+            DC_TRACE_SCOPE("DivePlanWindow::setpointCellChanged");
             
             // Validate the row index is within bounds
             if (row < 0 || row >= static_cast<int>(m_divePlan->m_setPoints.nbOfSetPoints())) {
@@ -23,8 +22,8 @@ void DivePlanWindow::setpointCellChanged(int row, int column) {
             }
             
             // Get current values
-            double depth = m_divePlan->m_setPoints.m_depths[row];
-            double setpoint = m_divePlan->m_setPoints.m_setPoints[row];
+            double depth = m_divePlan->m_setPoints.getSetPoint(row).m_depth;
+            double setpoint = m_divePlan->m_setPoints.getSetPoint(row).m_setPoint;
             
             // Update with new value
             if (column == SP_COL_DEPTH) {
@@ -33,18 +32,16 @@ void DivePlanWindow::setpointCellChanged(int row, int column) {
                 setpoint = value;
             }
             
-            // Update the setpoint
-            m_divePlan->m_setPoints.m_depths[row] = depth;
-            m_divePlan->m_setPoints.m_setPoints[row] = setpoint;
-            m_divePlan->m_setPoints.sortSetPoints();
+            // Update the setpoint, which moves it to its sorted position
+            m_divePlan->m_setPoints.editSetPoint(row, depth, setpoint);
             
             // Save setpoints to file
             m_divePlan->m_setPoints.saveSetPointsToFile();
+            g_setPoints = m_divePlan->m_setPoints;
             
-            qDebug() << "editSetPoint() took" << timer.elapsed() << "ms";
-
             // Unlike stop steps, we don't need to rebuild for setpoint changes
             // We just need to refresh the dive plan to recalculate with new setpoints
+            m_divePlan->invalidate(PlanStage::TISSUES);
             refreshDivePlan();
             
             // Since sorting might have changed positions, refresh the table
@@ -61,16 +58,15 @@ void DivePlanWindow::addSetpoint() {
     if (isUpdating) return;
     isUpdating = true;
     
-    QElapsedTimer timer;
-    timer.start();
+    DC_TRACE_SCOPE("DivePlanWindow::addSetpoint");
     
     // Get the last setpoint as a reference
     double lastDepth = 0.0;
     double lastSetpoint = 0.7; // Default setpoint
     
     if (m_divePlan->m_setPoints.nbOfSetPoints() > 0) {
-        lastDepth = m_divePlan->m_setPoints.m_depths[0];
-        lastSetpoint = m_divePlan->m_setPoints.m_setPoints[0];
+        lastDepth = m_divePlan->m_setPoints.getSetPoint(0).m_depth;
+        lastSetpoint = m_divePlan->m_setPoints.getSetPoint(0).m_setPoint;
     }
     
     // Add a new setpoint with similar values
@@ -78,15 +74,13 @@ void DivePlanWindow::addSetpoint() {
     
     // Save setpoints to file
     m_divePlan->m_setPoints.saveSetPointsToFile();
+    g_setPoints = m_divePlan->m_setPoints;
     
-    qDebug() << "addSetPoint() took" << timer.elapsed() << "ms";
-    
-    timer.restart();
     // Refresh the setpoint table
     refreshSetpointsTable();
-    qDebug() << "refreshSetpointsTable() took" << timer.elapsed() << "ms";
 
     // Refresh the dive plan WITHOUT rebuilding
+    m_divePlan->invalidate(PlanStage::TISSUES);
     refreshDivePlan();
 
     // Allow UI to process events after the edit
@@ -103,23 +97,20 @@ void DivePlanWindow::deleteSetpoint(int row) {
     
     // Ensure we maintain at least one setpoint
     if (m_divePlan->m_setPoints.nbOfSetPoints() > 1) {
-        QElapsedTimer timer;
-        timer.start();
+        DC_TRACE_SCOPE("DivePlanWindow::deleteSetpoint");
         
         // Remove the specified setpoint
         m_divePlan->m_setPoints.removeSetPoint(row);
         
         // Save setpoints to file
         m_divePlan->m_setPoints.saveSetPointsToFile();
+        g_setPoints = m_divePlan->m_setPoints;
         
-        qDebug() << "removeSetPoint() took" << timer.elapsed() << "ms";
-        
-        timer.restart();
         // Refresh the setpoint table
         refreshSetpointsTable();
-        qDebug() << "refreshSetpointsTable() took" << timer.elapsed() << "ms";
 
         // Refresh the dive plan
+        m_divePlan->invalidate(PlanStage::TISSUES);
         refreshDivePlan();
 
         // Allow UI to process events after the edit
@@ -146,6 +137,8 @@ void DivePlanWindow::setupSetpointsTable() {
 }
 
 void DivePlanWindow::refreshSetpointsTable() {
+    DC_TRACE_SCOPE("DivePlanWindow::refreshSetpointsTable");
+
     // Use the TableHelper for safe update
     TableHelper::safeUpdate(setpointsTable, this, &DivePlanWindow::setpointCellChanged, [this]() {
         // Set number of rows
@@ -155,11 +148,11 @@ void DivePlanWindow::refreshSetpointsTable() {
         for (int i = 0; i < (int) m_divePlan->m_setPoints.nbOfSetPoints(); ++i) {
             // Depth item
             setpointsTable->setItem(i, SP_COL_DEPTH, 
-                TableHelper::createNumericCell(m_divePlan->m_setPoints.m_depths[i], 1, true));
+                TableHelper::createNumericCell(m_divePlan->m_setPoints.getSetPoint(i).m_depth, 1, true));
             
             // Setpoint item
             setpointsTable->setItem(i, SP_COL_SETPOINT, 
-                TableHelper::createNumericCell(m_divePlan->m_setPoints.m_setPoints[i], 2, true));
+                TableHelper::createNumericCell(m_divePlan->m_setPoints.getSetPoint(i).m_setPoint, 2, true));
             
             // Delete button (except for the last row if there's only one)
             if (m_divePlan->m_setPoints.nbOfSetPoints() > 1 || i < (int) m_divePlan->m_setPoints.nbOfSetPoints() - 1) {
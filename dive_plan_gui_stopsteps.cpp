@@ -25,11 +25,16 @@ void DivePlanWindow::stopStepCellChanged(int row, int column){
                 time = value;
             }
             
-            // Update the stop step
-            m_divePlan->m_stopSteps.editStopStep(row, depth, time);
-
-            // Rebuild and refreshthe dive plan
-            rebuildDivePlan();
+            if (column == STOP_COL_TIME) {
+                // Same layout: recalculated from that stop on
+                m_divePlan->editStopStepTime(row, time);
+            } else {
+                // Update the stop step
+                m_divePlan->m_stopSteps.editStopStep(row, depth, time);
+
+                // Rebuild and refreshthe dive plan
+                rebuildDivePlan();
+            }
             refreshDivePlan();
 
             // Allow UI to process events after the edit
@@ -150,6 +155,8 @@ void DivePlanWindow::setupStopStepsTable() {
 }
 
 void DivePlanWindow::refreshStopStepsTable() {
+    DC_TRACE_SCOPE("DivePlanWindow::refreshStopStepsTable");
+
     if (m_isUpdating) {
         qDebug() << "Skipping refreshStopStepsTable() - already updating";
         return; // Prevent recursive calls
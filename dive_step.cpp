@@ -14,15 +14,16 @@ std::ostream& operator<<(std::ostream& os, const DiveStep& step)
     return os;
 }
 
-double DiveStep::getGFSurface(DiveStep *stepSurface){
+double DiveStep::getGFSurface(const DiveStep *stepSurface, const PlanContext& context){
     double GF_surface = 0;
+    double atmPressure = context.m_parameters.m_atmPressure;
     
     for (int j = 0; j < NUM_COMPARTMENTS; j++){
         double GF_surface_n2 = 0, GF_surface_he = 0, GF_surface_inert = 0;
 
-        GF_surface_n2    = (m_ppActual[j].m_pN2    - g_parameters.m_atmPressure) / (stepSurface->m_ppMax[j].m_pN2    - g_parameters.m_atmPressure) * 100;
-        GF_surface_he    = (m_ppActual[j].m_pHe    - g_parameters.m_atmPressure) / (stepSurface->m_ppMax[j].m_pHe    - g_parameters.m_atmPressure) * 100;
-        GF_surface_inert = (m_ppActual[j].m_pInert - g_parameters.m_atmPressure) / (stepSurface->m_ppMax[j].m_pInert - g_parameters.m_atmPressure) * 100;
+        GF_surface_n2    = (m_ppActual.pN2(j)    - atmPressure) / (stepSurface->m_ppMax[j].m_pN2    - atmPressure) * 100;
+        GF_surface_he    = (m_ppActual.pHe(j)    - atmPressure) / (stepSurface->m_ppMax[j].m_pHe    - atmPressure) * 100;
+        GF_surface_inert = (m_ppActual.pInert(j) - atmPressure) / (stepSurface->m_ppMax[j].m_pInert - atmPressure) * 100;
 
         GF_surface = std::max(GF_surface, GF_surface_n2);
         GF_surface = std::max(GF_surface, GF_surface_he);
@@ -32,22 +33,23 @@ double DiveStep::getGFSurface(DiveStep *stepSurface){
     return GF_surface;
 }
 
-double DiveStep::getCeiling(double GF){
+double DiveStep::getCeiling(double GF, const PlanContext& context){
     double ceiling_n2 = 0, ceiling_he = 0, ceiling_inert = 0;
+    const BuhlmannModel& model = context.m_buhlmannModel;
 
     for (int j = 0; j < NUM_COMPARTMENTS; j++){
         double p_amb_min_n2, p_amb_min_he, p_amb_min_inert;
         
         // N2
-        double a_n2 = g_buhlmannModel.m_compartments[j].m_aN2;
-        double b_n2 = g_buhlmannModel.m_compartments[j].m_bN2;
-        p_amb_min_n2 = (m_ppActual[j].m_pN2 - a_n2 * GF / 100) /  (1 + (1 / b_n2 - 1) * GF / 100);
+        double a_n2 = model.m_compartments[j].m_aN2;
+        double b_n2 = model.m_compartments[j].m_bN2;
+        p_amb_min_n2 = (m_ppActual.pN2(j) - a_n2 * GF / 100) /  (1 + (1 / b_n2 - 1) * GF / 100);
         ceiling_n2 = std::max(ceiling_n2, getDepthFromPressure(p_amb_min_n2));
         
         // He
-        double a_he = g_buhlmannModel.m_compartments[j].m_aHe;
-        double b_he = g_buhlmannModel.m_compartments[j].m_bHe;
-        p_amb_min_he = (m_ppActual[j].m_pHe - a_he * GF / 100) /  (1 + (1 / b_he - 1) * GF / 100);
+        double a_he = model.m_compartments[j].m_aHe;
+        double b_he = model.m_compartments[j].m_bHe;
+        p_amb_min_he = (m_ppActual.pHe(j) - a_he * GF / 100) /  (1 + (1 / b_he - 1) * GF / 100);
         ceiling_he = std::max(ceiling_he, getDepthFromPressure(p_amb_min_he));
         
             
@@ -61,54 +63,39 @@ double DiveStep::getCeiling(double GF){
             ratio_n2_he = m_n2Percent / total_inert_percent;
         }
             
-        double a_inert = g_buhlmannModel.m_compartments[j].m_aN2 * ratio_n2_he + g_buhlmannModel.m_compartments[j].m_aHe * (1 - ratio_n2_he);
-        double b_inert = g_buhlmannModel.m_compartments[j].m_bN2 * ratio_n2_he + g_buhlmannModel.m_compartments[j].m_bHe * (1 - ratio_n2_he);
-        p_amb_min_inert = (m_ppActual[j].m_pInert - a_inert * GF / 100) /  (1 + (1 / b_inert - 1) * GF / 100);
+        double a_inert = model.m_compartments[j].m_aN2 * ratio_n2_he + model.m_compartments[j].m_aHe * (1 - ratio_n2_he);
+        double b_inert = model.m_compartments[j].m_bN2 * ratio_n2_he + model.m_compartments[j].m_bHe * (1 - ratio_n2_he);
+        p_amb_min_inert = (m_ppActual.pInert(j) - a_inert * GF / 100) /  (1 + (1 / b_inert - 1) * GF / 100);
         ceiling_inert = std::max(ceiling_inert, getDepthFromPressure(p_amb_min_inert));
     }
 
     return std::max(ceiling_n2, std::max(ceiling_he, ceiling_inert));
 }
 
-void DiveStep::calculatePPInertGasForStep(DiveStep& previousStep, double time) {
-    double pAmbStart = m_pAmbStartDepth;
-    double pAmbEnd = m_pAmbEndDepth;
-    double inertPercentN2 = m_n2Percent;
-    double inertPercentHe = m_hePercent;
+void DiveStep::calculatePPInertGasForStep(DiveStep& previousStep, double time, const PlanContext& context) {
+    SchreinerDecay scratch;
+    const SchreinerDecay& decay = context.m_buhlmannModel.getDecay(time, scratch);
 
-    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
-        double p0N2 = 0.0;
-        double p0He = 0.0;
-            
-        p0N2 = previousStep.m_ppActual[j].m_pN2;
-        p0He = previousStep.m_ppActual[j].m_pHe; 
-
-        double halfTimeN2 = g_buhlmannModel.getCompartment(j).m_halfTimeN2;
-        double halfTimeHe = g_buhlmannModel.getCompartment(j).m_halfTimeHe;
-
-        double pN2 = getSchreinerEquation(p0N2, halfTimeN2, pAmbStart, pAmbEnd, time, inertPercentN2);
-        double pHe = getSchreinerEquation(p0He, halfTimeHe, pAmbStart, pAmbEnd, time, inertPercentHe);
-        double pInert = pN2 + pHe;
-
-        CompartmentPP pp(pN2, pHe, pInert);
-        m_ppActual[j] = pp;
-    }
+    applySchreiner(previousStep.m_ppActual, m_ppActual, decay,
+                   m_pAmbStartDepth, m_pAmbEndDepth, m_n2Percent, m_hePercent);
 }
 
-void DiveStep::calculatePPInertGasMaxForStep(double& lastRatioN2He) {
+void DiveStep::calculatePPInertGasMaxForStep(double& lastRatioN2He, const PlanContext& context) {
+    const BuhlmannModel& model = context.m_buhlmannModel;
+
     // calculated on the lowest P_amb during that phase
     double pAmb = std::min(m_pAmbEndDepth, m_pAmbStartDepth);
     double gf = m_gf;
 
     for (int j = 0; j < NUM_COMPARTMENTS; j++) {
         // N2
-        double aN2 = g_buhlmannModel.getCompartment(j).m_aN2;
-        double bN2 = g_buhlmannModel.getCompartment(j).m_bN2;
+        double aN2 = model.getCompartment(j).m_aN2;
+        double bN2 = model.getCompartment(j).m_bN2;
         double pMaxN2 = aN2 + pAmb / bN2;
 
         // He
-        double aHe = g_buhlmannModel.getCompartment(j).m_aHe;
-        double bHe = g_buhlmannModel.getCompartment(j).m_bHe;
+        double aHe = model.getCompartment(j).m_aHe;
+        double bHe = model.getCompartment(j).m_bHe;
         double pMaxHe = aHe + pAmb / bHe;
             
         // Create PPMax object for this compartment
@@ -128,10 +115,10 @@ void DiveStep::calculatePPInertGasMaxForStep(double& lastRatioN2He) {
             lastRatioN2He = ratioN2He;
         }
             
-        double aInert = g_buhlmannModel.getCompartment(j).m_aN2 * ratioN2He + 
-                      g_buhlmannModel.getCompartment(j).m_aHe * (1.0 - ratioN2He);
-        double bInert = g_buhlmannModel.getCompartment(j).m_bN2 * ratioN2He + 
-                      g_buhlmannModel.getCompartment(j).m_bHe * (1.0 - ratioN2He);
+        double aInert = model.getCompartment(j).m_aN2 * ratioN2He + 
+                      model.getCompartment(j).m_aHe * (1.0 - ratioN2He);
+        double bInert = model.getCompartment(j).m_bN2 * ratioN2He + 
+                      model.getCompartment(j).m_bHe * (1.0 - ratioN2He);
         double pMaxInert = aInert + pAmb / bInert;
             
         // Update the PPMax object with the inert value
@@ -150,9 +137,9 @@ bool DiveStep::getIfBreachingDecoLimits() {
     bool breached = false;
     
     for (int j = 0; j < NUM_COMPARTMENTS; j++){
-         breached = (m_ppActual[j].m_pN2 > m_ppMaxAdjustedGF[j].m_pN2) ||
-                   (m_ppActual[j].m_pHe > m_ppMaxAdjustedGF[j].m_pHe) ||
-                   (m_ppActual[j].m_pInert > m_ppMaxAdjustedGF[j].m_pInert);            
+         breached = (m_ppActual.pN2(j) > m_ppMaxAdjustedGF[j].m_pN2) ||
+                   (m_ppActual.pHe(j) > m_ppMaxAdjustedGF[j].m_pHe) ||
+                   (m_ppActual.pInert(j) > m_ppMaxAdjustedGF[j].m_pInert);            
 
         if (breached) break;
     }
@@ -168,45 +155,46 @@ void DiveStep::updatePAmb(){
     m_pAmbMax = std::max(m_pAmbStartDepth, m_pAmbEndDepth);
 }
 
-void DiveStep::updateCeiling(double GF){
-    m_ceiling = getCeiling(GF);
+void DiveStep::updateCeiling(double GF, const PlanContext& context){
+    m_ceiling = getCeiling(GF, context);
 }
 
-void DiveStep::updateOxygenToxicity(DiveStep *previousStep){
+void DiveStep::updateOxygenToxicity(DiveStep *previousStep, const PlanContext& context){
+    const OxygenToxicity& oxygenToxicity = context.m_oxygenToxicity;
 
-    m_cnsMaxMinSingleDive = g_oxygenToxicity.getCNSMaxMin(m_pO2Max, true);
+    m_cnsMaxMinSingleDive = oxygenToxicity.getCNSMaxMin(m_pO2Max, true);
     if(m_cnsMaxMinSingleDive != 0.0) m_cnsStepSingleDive = m_time / m_cnsMaxMinSingleDive * 100;
     else m_cnsStepSingleDive = 0.0;
     m_cnsTotalSingleDive = previousStep->m_cnsTotalSingleDive + m_cnsStepSingleDive;
 
-    m_cnsMaxMinMultipleDives = g_oxygenToxicity.getCNSMaxMin(m_pO2Max, false);
+    m_cnsMaxMinMultipleDives = oxygenToxicity.getCNSMaxMin(m_pO2Max, false);
     if(m_cnsMaxMinMultipleDives != 0.0) m_cnsStepMultipleDives = m_time / m_cnsMaxMinMultipleDives * 100;
     else m_cnsStepMultipleDives = 0.0;
     m_cnsTotalMultipleDives = previousStep->m_cnsTotalMultipleDives + m_cnsStepMultipleDives;
         
-    m_otuPerMin = g_oxygenToxicity.getOTUPerMin(m_pO2Max);
+    m_otuPerMin = oxygenToxicity.getOTUPerMin(m_pO2Max);
     m_otuStep = m_time * m_otuPerMin;
     m_otuTotal = previousStep->m_otuTotal + m_otuStep;
 
 }
 
+// At the deepest point of the step, m_pAmbMax
 void DiveStep::updateDensity(){
-    Gas tempGas(m_o2Percent, m_hePercent, GasType::BOTTOM, GasStatus::ACTIVE);
-    m_gasDensity = tempGas.Density(std::max(m_startDepth, m_endDepth));
+    m_gasDensity = m_gasProperties.getDensity(m_pAmbMax);
 }
 
 void DiveStep::updateEND(){
-    Gas tempGas(m_o2Percent, m_hePercent, GasType::BOTTOM, GasStatus::ACTIVE);
-    m_endWithoutO2 = tempGas.ENDWithoutO2(std::max(m_startDepth, m_endDepth));
-    m_endWithO2 = tempGas.ENDWithO2(std::max(m_startDepth, m_endDepth));
+    m_endWithoutO2 = m_gasProperties.getENDWithoutO2(m_pAmbMax);
+    m_endWithO2 = m_gasProperties.getENDWithO2(m_pAmbMax);
 }
 
-void DiveStep::updateConsumption(){
+void DiveStep::updateConsumption(const PlanContext& context){
+        const Parameters& parameters = context.m_parameters;
         m_sacRate = 
             (m_mode == stepMode::CC) ? 0 : 
-            (m_mode == stepMode::BAILOUT) ? g_parameters.m_sacBailout : 
-            (m_mode == stepMode::OC) ? g_parameters.m_sacBottom : 
-            g_parameters.m_sacDeco;
+            (m_mode == stepMode::BAILOUT) ? parameters.m_sacBailout : 
+            (m_mode == stepMode::OC) ? parameters.m_sacBottom : 
+            parameters.m_sacDeco;
 
         m_ambConsumptionAtDepth = m_sacRate * 
             (getPressureFromDepth(m_startDepth) + getPressureFromDepth(m_endDepth)) / 2.0;
@@ -214,9 +202,9 @@ void DiveStep::updateConsumption(){
         m_stepConsumption = m_time * m_ambConsumptionAtDepth;
 }
 
-void DiveStep::updateGFSurface(DiveStep *stepSurface){
+void DiveStep::updateGFSurface(const DiveStep *stepSurface, const PlanContext& context){
 
-    m_gfSurface = getGFSurface(stepSurface);
+    m_gfSurface = getGFSurface(stepSurface, context);
 
 }
 
@@ -242,11 +230,11 @@ void DiveStep::printStepDetails(const int step) const {
                   << std::setw(4) << m_gf << "  |     " 
                   << std::fixed << std::setprecision(2)
                   << std::setw(5) << m_ppMaxAdjustedGF[j].m_pN2 << "| " 
-                  << std::setw(5) << m_ppActual[j].m_pN2 << " |     " 
+                  << std::setw(5) << m_ppActual.pN2(j) << " |     " 
                   << std::setw(5) << m_ppMaxAdjustedGF[j].m_pHe << "| " 
-                  << std::setw(5) << m_ppActual[j].m_pHe << " |        " 
+                  << std::setw(5) << m_ppActual.pHe(j) << " |        " 
                   << std::setw(5) << m_ppMaxAdjustedGF[j].m_pInert << "| " 
-                  << std::setw(5) << m_ppActual[j].m_pInert << "    |" 
+                  << std::setw(5) << m_ppActual.pInert(j) << "    |" 
                   << std::setw(5) << m_o2Percent << "   /   " 
                   << std::setw(5) << m_hePercent << std::endl;
     }
@@ -263,11 +251,11 @@ void DiveStep::printCompartmentDetails(const int step, const int compartment) co
               << std::setw(4) << m_gf << "  |     " 
               << std::fixed << std::setprecision(2)
               << std::setw(5) << m_ppMaxAdjustedGF[compartment].m_pN2 << "| " 
-              << std::setw(5) << m_ppActual[compartment].m_pN2 << " |     " 
+              << std::setw(5) << m_ppActual.pN2(compartment) << " |     " 
               << std::setw(5) << m_ppMaxAdjustedGF[compartment].m_pHe << "| " 
-              << std::setw(5) << m_ppActual[compartment].m_pHe << " |        " 
+              << std::setw(5) << m_ppActual.pHe(compartment) << " |        " 
               << std::setw(5) << m_ppMaxAdjustedGF[compartment].m_pInert << "| " 
-              << std::setw(5) << m_ppActual[compartment].m_pInert << "    |" 
+              << std::setw(5) << m_ppActual.pInert(compartment) << "    |" 
               << std::setw(5) << m_o2Percent << "   /   " 
               << std::setw(5) << m_hePercent << std::endl;
 }
@@ -1,6 +1,7 @@
 #ifndef dive_step_HPP
 #define dive_step_HPP
 
+#include <array>
 #include <string>
 #include <memory>
 #include <vector>
@@ -9,10 +10,12 @@
 #include <iostream>
 #include <iomanip>
 #include "compartments.hpp"
+#include "tissue_state.hpp"
 #include "buhlmann.hpp"
 #include "global.hpp"
 #include "oxygen_toxicity.hpp"
 #include "gas.hpp"
+#include "plan_context.hpp"
 
 namespace DiveComputer {
 
@@ -45,14 +48,16 @@ public:
     double m_gf{0.0};
     double m_gfSurface{0.0};
 
-    std::vector<CompartmentPP> m_ppMax{NUM_COMPARTMENTS};
-    std::vector<CompartmentPP> m_ppMaxAdjustedGF{NUM_COMPARTMENTS};
-    std::vector<CompartmentPP> m_ppActual{NUM_COMPARTMENTS};
+    std::array<CompartmentPP, NUM_COMPARTMENTS> m_ppMax{};
+    std::array<CompartmentPP, NUM_COMPARTMENTS> m_ppMaxAdjustedGF{};
+    TissueState m_ppActual;
 
     double m_sacRate{0.0};
     double m_ambConsumptionAtDepth{0.0};
     double m_stepConsumption{0.0};
 
+    int    m_gasIndex{-1};              // in the plan's m_gasAvailable, -1 if the mix is not in it
+    GasProperties m_gasProperties;      // of the mix breathed, set with it when gases are applied
     double m_gasDensity{0.0};
     double m_endWithoutO2{0.0};
     double m_endWithO2{0.0};
@@ -71,19 +76,19 @@ public:
 
     double m_ceiling{0.0};
 
-    // Core functions    
-    double getGFSurface(DiveStep *stepSurface);
-    double getCeiling(double GF);
-    void   calculatePPInertGasForStep(DiveStep& previousStep, double time);
-    void   calculatePPInertGasMaxForStep(double& lastRatioN2He);
+    // Core functions, reading model and settings from the plan's context
+    double getGFSurface(const DiveStep *stepSurface, const PlanContext& context);
+    double getCeiling(double GF, const PlanContext& context);
+    void   calculatePPInertGasForStep(DiveStep& previousStep, double time, const PlanContext& context);
+    void   calculatePPInertGasMaxForStep(double& lastRatioN2He, const PlanContext& context);
     bool   getIfBreachingDecoLimits();
 
     // update functions
     void updatePAmb();
-    void updateCeiling(double GF);
-    void updateOxygenToxicity(DiveStep *previousStep);
-    void updateConsumption();
-    void updateGFSurface(DiveStep *stepSurface);
+    void updateCeiling(double GF, const PlanContext& context);
+    void updateOxygenToxicity(DiveStep *previousStep, const PlanContext& context);
+    void updateConsumption(const PlanContext& context);
+    void updateGFSurface(const DiveStep *stepSurface, const PlanContext& context);
     void updateDensity();
     void updateEND();
     void updateRunTime(DiveStep *previousDiveStep);
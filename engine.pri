@@ -0,0 +1,12 @@
+# Link against the engine library; include from any project built after it
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+ENGINE_BUILD_DIR = $$shadowed($$PWD)
+LIBS += -L$$ENGINE_BUILD_DIR -lDiveComputerEngine
+
+win32:!win32-g++ {
+    PRE_TARGETDEPS += $$ENGINE_BUILD_DIR/DiveComputerEngine.lib
+} else {
+    PRE_TARGETDEPS += $$ENGINE_BUILD_DIR/libDiveComputerEngine.a
+}
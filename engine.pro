@@ -0,0 +1,54 @@
+# Headless planning engine: static library with no Qt dependency
+TEMPLATE = lib
+CONFIG += staticlib
+CONFIG -= qt
+TARGET = DiveComputerEngine
+
+include(common.pri)
+
+SOURCES += \
+    enum.cpp \
+    global.cpp \
+    constants.cpp \
+    parameters.cpp \
+    gas.cpp \
+    gaslist.cpp \
+    buhlmann.cpp \
+    compartments.cpp \
+    tissue_state.cpp \
+    oxygen_toxicity.cpp \
+    stop_steps.cpp \
+    set_points.cpp \
+    dive_step.cpp \
+    plan_context.cpp \
+    time_profile.cpp \
+    time_series.cpp \
+    dive_plan.cpp \
+    thread_pool.cpp \
+    trace.cpp \
+    perf_counters.cpp \
+    log.cpp
+
+HEADERS += \
+    error_handler.hpp \
+    global.hpp \
+    enum.hpp \
+    constants.hpp \
+    parameters.hpp \
+    gas.hpp \
+    gaslist.hpp \
+    buhlmann.hpp \
+    compartments.hpp \
+    tissue_state.hpp \
+    oxygen_toxicity.hpp \
+    stop_steps.hpp \
+    set_points.hpp \
+    dive_step.hpp \
+    plan_context.hpp \
+    time_profile.hpp \
+    time_series.hpp \
+    dive_plan.hpp \
+    thread_pool.hpp \
+    trace.hpp \
+    perf_counters.hpp \
+    log.hpp
@@ -0,0 +1,82 @@
+// ErrorDialog.hpp
+#ifndef ERROR_DIALOG_HPP
+#define ERROR_DIALOG_HPP
+
+#include "qtheaders.hpp"
+#include "error_handler.hpp"
+
+namespace DiveComputer {
+
+// Qt front-end of ErrorHandler: the engine only logs, the GUI shows the dialogs
+class ErrorDialog {
+public:
+    // Route engine error reports to message boxes; call once QApplication exists
+    static void install() {
+        ErrorHandler::setDialogHandler([](const std::string& title, const std::string& message, ErrorSeverity severity) {
+            showErrorDialog(QString::fromStdString(title), QString::fromStdString(message), severity);
+        });
+    }
+
+    // Display error dialog with appropriate styling based on severity
+    static void showErrorDialog(const QString& title, const QString& message, 
+                               ErrorSeverity severity = ErrorSeverity::ERROR) {
+        QMessageBox msgBox;
+        msgBox.setWindowTitle(title);
+        msgBox.setText(message);
+        
+        switch (severity) {
+            case ErrorSeverity::INFO:
+                msgBox.setIcon(QMessageBox::Information);
+                break;
+            case ErrorSeverity::WARNING:
+                msgBox.setIcon(QMessageBox::Warning);
+                break;
+            case ErrorSeverity::ERROR:
+                msgBox.setIcon(QMessageBox::Critical);
+                break;
+            case ErrorSeverity::CRITICAL:
+                msgBox.setIcon(QMessageBox::Critical);
+                break;
+        }
+        
+        msgBox.exec();
+    }
+    
+    // Validate numeric input with bounds checking
+    static bool validateNumericInput(const QString& input, double& value,
+                                   double minValue, double maxValue,
+                                   const QString& fieldName,
+                                   bool showErrorDialog = true) {
+        bool ok;
+        value = input.toDouble(&ok);
+        
+        if (!ok) {
+            if (showErrorDialog) {
+                ErrorDialog::showErrorDialog(QString("Invalid Input"), 
+                               QString("'%1' is not a valid number for %2.")
+                               .arg(input)
+                               .arg(fieldName),
+                               ErrorSeverity::WARNING);
+            }
+            return false;
+        }
+        
+        if (value < minValue || value > maxValue) {
+            if (showErrorDialog) {
+                ErrorDialog::showErrorDialog(QString("Out of Range"), 
+                               QString("Value for %1 must be between %2 and %3.")
+                               .arg(fieldName)
+                               .arg(minValue)
+                               .arg(maxValue),
+                               ErrorSeverity::WARNING);
+            }
+            return false;
+        }
+        
+        return true;
+    }
+};
+
+} // namespace DiveComputer
+
+#endif // ERROR_DIALOG_HPP
@@ -2,10 +2,12 @@
 #ifndef ERROR_HANDLER_HPP
 #define ERROR_HANDLER_HPP
 
-#include "qtheaders.hpp"
 #include <string>
+#include <filesystem>
 #include <functional>
+#include <ios>
 #include <iostream>
+#include "log.hpp"
 
 namespace DiveComputer {
 
@@ -19,57 +21,50 @@ enum class ErrorSeverity {
 
 class ErrorHandler {
 public:
-    // Display error dialog with appropriate styling based on severity
-    static void showErrorDialog(const QString& title, const QString& message, 
+    // Front-ends that can show dialogs install a handler; headless builds only log
+    using DialogHandler = std::function<void(const std::string& title, const std::string& message, ErrorSeverity severity)>;
+
+    static void setDialogHandler(DialogHandler handler) {
+        dialogHandler() = std::move(handler);
+    }
+
+    // Display error dialog through the installed handler, if any
+    static void showErrorDialog(const std::string& title, const std::string& message, 
                                ErrorSeverity severity = ErrorSeverity::ERROR) {
-        QMessageBox msgBox;
-        msgBox.setWindowTitle(title);
-        msgBox.setText(message);
-        
-        switch (severity) {
-            case ErrorSeverity::INFO:
-                msgBox.setIcon(QMessageBox::Information);
-                break;
-            case ErrorSeverity::WARNING:
-                msgBox.setIcon(QMessageBox::Warning);
-                break;
-            case ErrorSeverity::ERROR:
-                msgBox.setIcon(QMessageBox::Critical);
-                break;
-            case ErrorSeverity::CRITICAL:
-                msgBox.setIcon(QMessageBox::Critical);
-                break;
+        if (dialogHandler()) {
+            dialogHandler()(title, message, severity);
         }
-        
-        msgBox.exec();
     }
     
-    // Log error to console
+    // Log error through the asynchronous log sink; a critical error waits until it is written
     static void logError(const std::string& context, const std::string& message, 
                         ErrorSeverity severity = ErrorSeverity::ERROR) {
-        std::string severityStr;
+        LogLevel level = LogLevel::ERROR;
         switch (severity) {
             case ErrorSeverity::INFO:
-                severityStr = "INFO";
+                level = LogLevel::INFO;
                 break;
             case ErrorSeverity::WARNING:
-                severityStr = "WARNING";
+                level = LogLevel::WARNING;
                 break;
             case ErrorSeverity::ERROR:
-                severityStr = "ERROR";
+                level = LogLevel::ERROR;
                 break;
             case ErrorSeverity::CRITICAL:
-                severityStr = "CRITICAL";
+                level = LogLevel::CRITICAL;
                 break;
         }
         
-        std::cerr << "[" << severityStr << "] " << context << ": " << message << std::endl;
+        Log::write(level, context, message);
+        if (severity == ErrorSeverity::CRITICAL) {
+            Log::flush();
+        }
     }
     
     // Try operation with error handling
     template<typename Func>
     static bool tryOperation(Func operation, const std::string& context, 
-                        const QString& errorTitle,
+                        const std::string& errorTitle,
                         bool showDialog = true) {
         try {
             operation();
@@ -80,8 +75,7 @@ public:
             logError(context, errorMsg);
             
             if (showDialog) {
-                // Explicitly call the static method with correct arguments
-                ErrorHandler::showErrorDialog(errorTitle, QString::fromStdString(errorMsg));
+                ErrorHandler::showErrorDialog(errorTitle, errorMsg);
             }
             return false;
         }
@@ -90,8 +84,7 @@ public:
             logError(context, errorMsg);
             
             if (showDialog) {
-                // Explicitly call the static method with correct arguments
-                ErrorHandler::showErrorDialog(errorTitle, QString::fromStdString(errorMsg));
+                ErrorHandler::showErrorDialog(errorTitle, errorMsg);
             }
             return false;
         }
@@ -100,7 +93,7 @@ public:
     // Try file operation with specific error handling
     static bool tryFileOperation(std::function<void()> operation, 
                                const std::string& filePath,
-                               const QString& errorTitle,
+                               const std::string& errorTitle,
                                bool showErrorDialog = true) {
         try {
             operation();
@@ -112,9 +105,7 @@ public:
             
             if (showErrorDialog) {
                 ErrorHandler::showErrorDialog(errorTitle, 
-                               QString("Error accessing file: %1\n\nDetails: %2")
-                               .arg(QString::fromStdString(filePath))
-                               .arg(QString::fromStdString(e.what())));
+                               "Error accessing file: " + filePath + "\n\nDetails: " + e.what());
             }
             return false;
         }
@@ -124,9 +115,7 @@ public:
             
             if (showErrorDialog) {
                 ErrorHandler::showErrorDialog(errorTitle, 
-                               QString("Error reading/writing file: %1\n\nDetails: %2")
-                               .arg(QString::fromStdString(filePath))
-                               .arg(QString::fromStdString(e.what())));
+                               "Error reading/writing file: " + filePath + "\n\nDetails: " + e.what());
             }
             return false;
         }
@@ -136,9 +125,7 @@ public:
             
             if (showErrorDialog) {
                 ErrorHandler::showErrorDialog(errorTitle, 
-                               QString("Error with file: %1\n\nDetails: %2")
-                               .arg(QString::fromStdString(filePath))
-                               .arg(QString::fromStdString(e.what())));
+                               "Error with file: " + filePath + "\n\nDetails: " + e.what());
             }
             return false;
         }
@@ -148,45 +135,16 @@ public:
             
             if (showErrorDialog) {
                 ErrorHandler::showErrorDialog(errorTitle, 
-                               QString("Unknown error with file: %1")
-                               .arg(QString::fromStdString(filePath)));
+                               "Unknown error with file: " + filePath);
             }
             return false;
         }
     }
-    
-    // Validate numeric input with bounds checking
-    static bool validateNumericInput(const QString& input, double& value,
-                                   double minValue, double maxValue,
-                                   const QString& fieldName,
-                                   bool showErrorDialog = true) {
-        bool ok;
-        value = input.toDouble(&ok);
-        
-        if (!ok) {
-            if (showErrorDialog) {
-                ErrorHandler::showErrorDialog(QString("Invalid Input"), 
-                               QString("'%1' is not a valid number for %2.")
-                               .arg(input)
-                               .arg(fieldName),
-                               ErrorSeverity::WARNING);
-            }
-            return false;
-        }
-        
-        if (value < minValue || value > maxValue) {
-            if (showErrorDialog) {
-                ErrorHandler::showErrorDialog(QString("Out of Range"), 
-                               QString("Value for %1 must be between %2 and %3.")
-                               .arg(fieldName)
-                               .arg(minValue)
-                               .arg(maxValue),
-                               ErrorSeverity::WARNING);
-            }
-            return false;
-        }
-        
-        return true;
+
+private:
+    static DialogHandler& dialogHandler() {
+        static DialogHandler handler;
+        return handler;
     }
 };
 
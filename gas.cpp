@@ -2,15 +2,37 @@
 
 namespace DiveComputer {
 
+GasProperties::GasProperties(double o2Percent, double hePercent, const Parameters& parameters) {
+    m_densityPerBar = (g_constants.m_tempStp / (parameters.m_tempMin + g_constants.m_tempStp)) *
+                      (o2Percent / 100.0 * g_constants.m_o2Density +
+                       hePercent / 100.0 * g_constants.m_heDensity +
+                       (100 - o2Percent - hePercent) / 100.0 * g_constants.m_n2Density);
+    m_narcoticWithoutO2 = ((100 - o2Percent - hePercent) / 100.0) / (1.0 - g_constants.m_oxygenInAir / 100.0);
+    m_narcoticWithO2 = (100 - hePercent) / 100.0;
+}
+
+double GasProperties::getENDWithoutO2(double pAmbient) const {
+    return std::max((m_narcoticWithoutO2 * pAmbient - g_constants.m_atmPressureStp) * g_constants.m_meterPerBar, 0.0);
+}
+
+double GasProperties::getENDWithO2(double pAmbient) const {
+    return std::max((m_narcoticWithO2 * pAmbient - g_constants.m_atmPressureStp) * g_constants.m_meterPerBar, 0.0);
+}
+
 Gas::Gas() { // Defaults to Air
     m_o2Percent = g_constants.m_oxygenInAir;
     m_hePercent = 0.0;
     m_gasType = GasType::BOTTOM;
     m_gasStatus = GasStatus::ACTIVE;
     m_MOD = MOD(g_parameters.m_PpO2Active);
+    m_properties = GasProperties(m_o2Percent, m_hePercent, g_parameters);
+}
+
+Gas::Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatus)
+    : Gas(o2Percent, hePercent, gasType, gasStatus, g_parameters) {
 }
 
-Gas::Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatus) {
+Gas::Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatus, const Parameters& parameters) {
     m_o2Percent = o2Percent;
     m_hePercent = hePercent;
     m_gasType = gasType;
@@ -18,14 +40,15 @@ Gas::Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatu
 
     double maxppO2 = 0.0;
     if (gasType == GasType::BOTTOM) {
-        maxppO2 = g_parameters.m_PpO2Active;
+        maxppO2 = parameters.m_PpO2Active;
     } else if (gasType == GasType::DECO) {
-        maxppO2 = g_parameters.m_PpO2Deco;
+        maxppO2 = parameters.m_PpO2Deco;
     } else if (gasType == GasType::DILUENT) {
-        maxppO2 = g_parameters.m_maxPpO2Diluent;
+        maxppO2 = parameters.m_maxPpO2Diluent;
     }
 
     m_MOD = MOD(maxppO2);
+    m_properties = GasProperties(m_o2Percent, m_hePercent, parameters);
 }
 
 Gas Gas::bestGasForDepth(double depth, GasType gasType) {
@@ -51,8 +74,12 @@ double Gas::MOD(double ppO2) const {
 }
 
 double Gas::Density(double depth) const {
+    return Density(depth, g_parameters.m_tempMin);
+}
+
+double Gas::Density(double depth, double tempMin) const {
     double density = getPressureFromDepth(depth) * 
-                   (g_constants.m_tempStp / (g_parameters.m_tempMin + g_constants.m_tempStp)) * 
+                   (g_constants.m_tempStp / (tempMin + g_constants.m_tempStp)) * 
                    (m_o2Percent / 100.0 * g_constants.m_o2Density + 
                     m_hePercent / 100.0 * g_constants.m_heDensity + 
                     (100 - m_o2Percent - m_hePercent) / 100.0 * g_constants.m_n2Density);
@@ -61,17 +88,11 @@ double Gas::Density(double depth) const {
 }
 
 double Gas::ENDWithoutO2(double depth) const {
-    double END = (((100 - m_o2Percent - m_hePercent) / 100.0) / (1.0 - g_constants.m_oxygenInAir / 100.0) * getPressureFromDepth(depth) - 
-                g_constants.m_atmPressureStp) * g_constants.m_meterPerBar;
-    
-    return std::max(END, 0.0);
+    return m_properties.getENDWithoutO2(getPressureFromDepth(depth));
 }
 
 double Gas::ENDWithO2(double depth) const {
-    double END = ((100 - m_hePercent) / 100.0 * getPressureFromDepth(depth) - 
-               g_constants.m_atmPressureStp) * g_constants.m_meterPerBar;
-
-    return std::max(END, 0.0);
+    return m_properties.getENDWithO2(getPressureFromDepth(depth));
 }
 
 } // namespace DiveComputer
\ No newline at end of file
@@ -8,12 +8,28 @@
 
 namespace DiveComputer {
 
+// Mix dependent coefficients of density and END, computed once per gas and set of parameters.
+// Both are linear in ambient pressure, so a step only needs a multiply-add
+struct GasProperties {
+    GasProperties() = default;
+    GasProperties(double o2Percent, double hePercent, const Parameters& parameters);
+
+    double m_densityPerBar{0.0};        // g/l per bar of ambient pressure, at the minimum temperature
+    double m_narcoticWithoutO2{0.0};    // narcotic fraction relative to air, O2 not narcotic
+    double m_narcoticWithO2{0.0};       // narcotic fraction, O2 as narcotic as N2
+
+    double getDensity(double pAmbient) const { return m_densityPerBar * pAmbient; }
+    double getENDWithoutO2(double pAmbient) const;
+    double getENDWithO2(double pAmbient) const;
+};
+
  // Gas class
 class Gas {
 public:
     // Constructor
     Gas();
     Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatus);
+    Gas(double o2Percent, double hePercent, GasType gasType, GasStatus gasStatus, const Parameters& parameters);
 
     // Attributes
     double    m_o2Percent{0.0};
@@ -21,11 +37,13 @@ public:
     GasType   m_gasType{};
     GasStatus m_gasStatus{};
     double    m_MOD{0.0};
+    GasProperties m_properties;
 
     // Methods
     static Gas bestGasForDepth(double depth, GasType gasType);
     double MOD(double ppO2) const;
     double Density(double depth) const;
+    double Density(double depth, double tempMin) const;
     double ENDWithoutO2(double depth) const;
     double ENDWithO2(double depth) const;
 
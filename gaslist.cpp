@@ -1,4 +1,5 @@
 #include "gaslist.hpp"
+#include "log.hpp"
 
 namespace DiveComputer {
 
@@ -13,8 +14,6 @@ GasList g_gasList;
 
 // Constructor implements Pimpl idiom
 GasList::GasList() : pImpl(std::make_unique<Impl>()) {
-    // Ensure app info is set before any path operations
-    ensureAppInfoSet();
     loadGaslistFromFile();
 }
 
@@ -41,7 +40,7 @@ void GasList::clearGaslist() {
 bool GasList::loadGaslistFromFile() {
     const std::string filename = getFilePath(GASLIST_FILE_NAME);
     
-    std::cout << "Trying to load gas list from: " << filename << std::endl;
+    DC_LOG_DEBUG("GasList", "Trying to load gas list from: " << filename);
     
     // If file doesn't exist, add default gas and return
     if (!std::filesystem::exists(filename)) {
@@ -159,30 +158,4 @@ const std::vector<Gas>& GasList::getGases() const {
     return pImpl->gases;
 }
 
-std::string GasList::getFilePath(const std::string& filename) {
-    // Use QStandardPaths to get the app data location
-    QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    
-    // Ensure the directory exists
-    QDir dir(appDataPath);
-    if (!dir.exists()) {
-        dir.mkpath(".");
-    }
-    
-    // Construct full file path
-    QString fullPath = QDir(appDataPath).filePath(QString::fromStdString(filename));
-    
-    // Convert back to std::string
-    return fullPath.toStdString();
-}
-
-void GasList::ensureAppInfoSet() {
-    // Ensure the application data directory exists
-    QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir dir(appDataPath);
-    if (!dir.exists()) {
-        dir.mkpath(".");
-    }
-}
-
 } // namespace DiveComputer
\ No newline at end of file
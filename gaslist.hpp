@@ -1,7 +1,6 @@
 #ifndef GASLIST_HPP
 #define GASLIST_HPP
 
-#include "qtheaders.hpp"
 #include "error_handler.hpp"
 #include "gas.hpp"
 #include <vector>
@@ -47,12 +46,6 @@ private:
     // Pimpl idiom for implementation details
     class Impl;
     std::unique_ptr<Impl> pImpl;
-
-    // Helper method to ensure app info is set
-    void ensureAppInfoSet();
-    
-    // Get file path for app-specific files
-    std::string getFilePath(const std::string& filename);
 };
 
 // Declare global instance
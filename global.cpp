@@ -1,87 +1,63 @@
 #include "global.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
 
 namespace DiveComputer {
 
-// Ensure app info is properly set for path resolution
-void ensureAppInfoSet() {
-    // Set the organization and application name if not already set
-    // These MUST be set before the first call to QStandardPaths
-    if (QCoreApplication::organizationName().isEmpty()) {
-        QCoreApplication::setOrganizationName("DiveComputer");
+// Per-user data directory, matching QStandardPaths::AppDataLocation for the
+// "DiveComputer" organisation and application so GUI and headless tools share files.
+// DIVECOMPUTER_DATA_DIR overrides it (batch jobs, servers, sandboxes)
+static std::filesystem::path getDataDirectory() {
+    const char* overrideDir = std::getenv("DIVECOMPUTER_DATA_DIR");
+    if (overrideDir && *overrideDir) {
+        return std::filesystem::path(overrideDir);
     }
-    if (QCoreApplication::applicationName().isEmpty()) {
-        QCoreApplication::setApplicationName("DiveComputer");
+
+    const std::filesystem::path appPath = std::filesystem::path("DiveComputer") / "DiveComputer";
+
+#if defined(_WIN32)
+    const char* appData = std::getenv("APPDATA");
+    if (appData && *appData) {
+        return std::filesystem::path(appData) / appPath;
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::filesystem::path(home) / "Library" / "Application Support" / appPath;
+    }
+#else
+    const char* xdgDataHome = std::getenv("XDG_DATA_HOME");
+    if (xdgDataHome && *xdgDataHome) {
+        return std::filesystem::path(xdgDataHome) / appPath;
     }
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::filesystem::path(home) / ".local" / "share" / appPath;
+    }
+#endif
+
+    return std::filesystem::current_path();
 }
 
 std::string getFilePath(const std::string& filename) {
-    // Ensure app info is set before getting the path
-    ensureAppInfoSet();
-    
-    // Get application data location
-    QString dataLocation = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    
-    // Print the location for debugging
-    std::cout << "Using AppDataLocation: " << dataLocation.toStdString() << std::endl;
-    
-    // Create directory if it doesn't exist
-    QDir dir(dataLocation);
-    if (!dir.exists()) {
-        bool created = dir.mkpath(".");
-        std::cout << "Created directory: " << (created ? "success" : "failed") << std::endl;
-    }
-    
-    // Get full path with filename
-    QString fullPath = dir.filePath(QString::fromStdString(filename));
-    
-    return fullPath.toStdString();
-}
+    std::filesystem::path dataLocation = getDataDirectory();
 
-void setWindowSizeAndPosition(QWidget* window, int preferredWidth, int preferredHeight, WindowPosition position) {
-    
-    int margin = 10;
+    DC_LOG_DEBUG("Global", "Using AppDataLocation: " << dataLocation.string());
 
-    // Get the screen resolution using the newer QScreen approach
-    QScreen *screen = QApplication::primaryScreen();
-    QRect screenGeometry = screen->availableGeometry();
-    
-    // Calculate appropriate window size (constrained by screen size)
-    int windowWidth = std::min(screenGeometry.width() - margin, preferredWidth);
-    int windowHeight = std::min(screenGeometry.height() - margin, preferredHeight);
-    window->resize(windowWidth, windowHeight);
-    
-    // Calculate window position based on requested position
-    int x, y;
-    
-    switch (position) {
-        case WindowPosition::CENTER:
-            x = (screenGeometry.width() - window->width()) / 2;
-            y = (screenGeometry.height() - window->height()) / 2;
-            break;
-            
-        case WindowPosition::TOP_LEFT:
-            x = screenGeometry.left();
-            y = screenGeometry.top();
-            break;
-            
-        case WindowPosition::TOP_RIGHT:
-            x = screenGeometry.right() - window->width();
-            y = screenGeometry.top();
-            break;
-            
-        case WindowPosition::BOTTOM_LEFT:
-            x = screenGeometry.left();
-            y = screenGeometry.bottom() - window->height();
-            break;
-            
-        case WindowPosition::BOTTOM_RIGHT:
-            x = screenGeometry.right() - window->width();
-            y = screenGeometry.bottom() - window->height();
-            break;
+    // Create directory if it doesn't exist
+    std::error_code error;
+    if (!std::filesystem::exists(dataLocation, error)) {
+        if (std::filesystem::create_directories(dataLocation, error)) {
+            DC_LOG_INFO("Global", "Created data directory " << dataLocation.string());
+        } else {
+            DC_LOG_WARNING("Global", "Could not create data directory " << dataLocation.string() << ": " << error.message());
+        }
     }
-    
-    // Move the window to the calculated position
-    window->move(x, y);
+
+    return (dataLocation / filename).string();
 }
 
 double getDepthFromPressure(double pressure) {
@@ -119,15 +95,18 @@ double getSchreinerEquation(double p0, double halfTime, double pAmbStartDepth, d
     return pi + r * (time - 1/k) - (pi - p0 - r/k) * exp(-k * time);
 }
 
-double getGF(double depth, double firstDecoDepth) {
+double getGF(double depth, double firstDecoDepth, const Parameters& parameters) {
     double gf;
 
     if (depth > firstDecoDepth) {
-        gf = g_parameters.m_gf[0];
+        gf = parameters.m_gf[0];
+    } else if (firstDecoDepth <= parameters.m_lastStopDepth) {
+        // First stop is the last stop: no range to interpolate over
+        gf = parameters.m_gf[1];
     } else {
-        gf = std::min(g_parameters.m_gf[1], 
-                g_parameters.m_gf[0] + (g_parameters.m_gf[1] - g_parameters.m_gf[0]) * 
-                (depth - firstDecoDepth) / (g_parameters.m_lastStopDepth - firstDecoDepth));
+        gf = std::min(parameters.m_gf[1], 
+                parameters.m_gf[0] + (parameters.m_gf[1] - parameters.m_gf[0]) * 
+                (depth - firstDecoDepth) / (parameters.m_lastStopDepth - firstDecoDepth));
     }
 
     return gf;
@@ -0,0 +1,56 @@
+QT += core widgets
+TARGET = DiveComputer
+
+include(common.pri)
+include(engine.pri)
+
+RESOURCES += resources.qrc
+
+SOURCES += \
+    main.cpp \
+    ui_utils.cpp \
+    parameters_gui.cpp \
+    gaslist_gui.cpp \
+    dive_plan_dialog.cpp \
+    dive_plan_gui.cpp \
+    dive_plan_gui_stopsteps.cpp \
+    dive_plan_gui_plantables.cpp \
+    dive_plan_gui_menu.cpp \
+    dive_plan_gui_gaslist.cpp \
+    dive_plan_gui_setpoints.cpp \
+    placeholder_gui.cpp \
+    main_gui.cpp
+
+HEADERS += \
+    qtheaders.hpp \
+    error_dialog.hpp \
+    table_helper.hpp \
+    parameters_gui.hpp \
+    gaslist_gui.hpp \
+    dive_plan_dialog.hpp \
+    dive_plan_gui.hpp \
+    placeholder_gui.hpp \
+    ui_utils.hpp \
+    main_gui.hpp
+
+# Add a post-link step that copies the executable and cleans up intermediate files
+macx {
+    # Script to:
+    # 1. Check if the app exists and copy the executable
+    # 2. Clean intermediate files but keep the app bundle and executable
+    QMAKE_POST_LINK = \
+        test -e $${TARGET}.app/Contents/MacOS/$${TARGET} && \
+        cp -f $${TARGET}.app/Contents/MacOS/$${TARGET} . && \
+        $(DEL_FILE) $(OBJECTS) && \
+        $(DEL_FILE) *~ core *.core moc_*.cpp moc_*.h moc_predefs.h || \
+        echo "App not found, skipping copy and cleanup"
+}
+
+# Define a full clean target for when you want to remove everything
+fullclean.commands = $(DEL_FILE) $(OBJECTS) && \
+                   $(DEL_FILE) *~ core *.core && \
+                   rm -f $${TARGET} && \
+                   rm -rf $${TARGET}.app && \
+                   rm -f .qmake.stash
+
+QMAKE_EXTRA_TARGETS += fullclean
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include "log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace DiveComputer {
+
+namespace {
+
+struct LogRecord {
+    LogLevel    m_level{LogLevel::INFO};
+    std::string m_context;
+    std::string m_message;
+};
+
+// Records waiting for the writer, a power of two; beyond this, new records are dropped rather than blocking
+const std::size_t LOG_QUEUE_CAPACITY = 4096;
+
+// Longest sleep of an idle writer, in case a wake-up is missed
+const auto LOG_WRITER_POLL = std::chrono::milliseconds(100);
+
+// Bounded multi-producer, single-consumer queue. Each cell carries a sequence number telling
+// whether it is free for the producer claiming position pos (sequence == pos) or holds the
+// record of position pos for the consumer (sequence == pos + 1). Producers only contend on
+// the claim of a position; a full queue fails instead of waiting. Positions only grow: every
+// record of a position below getDequeuePos() has been popped
+class LogQueue {
+public:
+    LogQueue() : m_cells(new Cell[LOG_QUEUE_CAPACITY]) {
+        for (std::size_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(LogRecord& record) {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &m_cells[pos & (LOG_QUEUE_CAPACITY - 1)];
+            std::size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) pos;
+
+            if (difference == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->m_record = std::move(record);
+        cell->m_sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Positions claimed so far, records still being stored included
+    std::size_t getEnqueuePos() const {
+        return m_enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    // Consumer side only
+    bool pop(LogRecord& record) {
+        Cell& cell = m_cells[m_dequeuePos & (LOG_QUEUE_CAPACITY - 1)];
+        if (cell.m_sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+            return false;
+        }
+
+        record = std::move(cell.m_record);
+        cell.m_sequence.store(m_dequeuePos + LOG_QUEUE_CAPACITY, std::memory_order_release);
+        m_dequeuePos++;
+        return true;
+    }
+
+    // Consumer side only
+    std::size_t getDequeuePos() const {
+        return m_dequeuePos;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> m_sequence{0};
+        LogRecord m_record;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+    alignas(64) std::size_t m_dequeuePos{0};
+};
+
+// Appends to path, rotating it to path.1 ... path.<maxFiles - 1> once it reaches maxBytes
+class RotatingFile {
+public:
+    ~RotatingFile() { close(); }
+
+    bool open(const std::string& path, std::size_t maxBytes, int maxFiles) {
+        close();
+        m_path = path;
+        m_maxBytes = maxBytes;
+        m_maxFiles = std::max(1, maxFiles);
+        return reopen();
+    }
+
+    void close() {
+        if (m_file) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    void write(const char* text, std::size_t length) {
+        if (!m_file) return;
+
+        if (m_size > 0 && m_size + length > m_maxBytes) {
+            rotate();
+            if (!m_file) return;
+        }
+        m_size += std::fwrite(text, 1, length, m_file);
+    }
+
+    void flush() {
+        if (m_file) std::fflush(m_file);
+    }
+
+private:
+    bool reopen() {
+        m_file = std::fopen(m_path.c_str(), "a");
+        if (!m_file) return false;
+
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(m_path, error);
+        m_size = error ? 0 : (std::size_t) size;
+        return true;
+    }
+
+    void rotate() {
+        close();
+
+        // The oldest file goes; a single file just starts over
+        std::error_code error;
+        std::filesystem::remove(getRotatedPath(m_maxFiles - 1), error);
+        for (int i = m_maxFiles - 2; i >= 1; i--) {
+            std::filesystem::rename(getRotatedPath(i), getRotatedPath(i + 1), error);
+        }
+        if (m_maxFiles > 1) {
+            std::filesystem::rename(m_path, getRotatedPath(1), error);
+        }
+        else {
+            std::filesystem::remove(m_path, error);
+        }
+
+        reopen();
+    }
+
+    std::string getRotatedPath(int index) const {
+        return m_path + "." + std::to_string(index);
+    }
+
+    std::string m_path;
+    std::size_t m_maxBytes{0};
+    int m_maxFiles{1};
+    std::FILE* m_file{nullptr};
+    std::size_t m_size{0};
+};
+
+// Producers queue records without locking; a background thread formats them and writes them
+// to stderr and the optional file, and drains the queue before exit. The mutex is only taken
+// to wake an idle writer, to wait for it, and to change the file. A CRITICAL record that finds
+// the queue full is written by its own thread instead
+class LogSink {
+public:
+    LogSink() {
+        m_writer = std::thread([this]() { run(); });
+    }
+
+    ~LogSink() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ready.notify_one();
+        m_writer.join();
+    }
+
+    void push(LogRecord record) {
+        if (!m_queue.push(record)) {
+            if (record.m_level == LogLevel::CRITICAL) {
+                writeNow(record);
+            }
+            else {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        // Sequentially consistent with the writer going to sleep: either it sees the count,
+        // or this thread sees it asleep
+        m_queued.fetch_add(1);
+        if (m_sleeping.load()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.notify_one();
+        }
+    }
+
+    // Waits for the positions claimed before the call, whichever thread claimed them, so the
+    // caller's own records are written even when other producers are still storing theirs
+    void flush() {
+        std::size_t position = m_queue.getEnqueuePos();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_written.wait(lock, [&]() { return m_writtenPos >= position; });
+    }
+
+    std::size_t getDroppedCount() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    bool setFile(const std::string& path, std::size_t maxBytes, int maxFiles) {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        if (path.empty()) {
+            m_file.close();
+            return true;
+        }
+        return m_file.open(path, maxBytes, maxFiles);
+    }
+
+    void setConsoleEnabled(bool enabled) {
+        m_console.store(enabled, std::memory_order_relaxed);
+    }
+
+private:
+    static void format(const LogRecord& record, std::string& line) {
+        line.clear();
+        line.append("[").append(Log::getLevelName(record.m_level)).append("] ");
+        line.append(record.m_context).append(": ").append(record.m_message).append("\n");
+    }
+
+    // After the records queued before it, so the order is kept
+    void writeNow(const LogRecord& record) {
+        flush();
+
+        std::string line;
+        format(record, line);
+        std::lock_guard<std::mutex> fileLock(m_fileMutex);
+        if (m_console.load(std::memory_order_relaxed)) {
+            std::fwrite(line.data(), 1, line.size(), stderr);
+            std::fflush(stderr);
+        }
+        m_file.write(line.data(), line.size());
+        m_file.flush();
+    }
+
+    void run() {
+        LogRecord record;
+        std::string line;
+        std::size_t reportedDropped = 0;
+
+        while (true) {
+            std::size_t written = 0;
+            std::size_t writtenPos = 0;
+            {
+                std::lock_guard<std::mutex> fileLock(m_fileMutex);
+                bool console = m_console.load(std::memory_order_relaxed);
+
+                while (m_queue.pop(record)) {
+                    format(record, line);
+                    if (console) std::fwrite(line.data(), 1, line.size(), stderr);
+                    m_file.write(line.data(), line.size());
+                    written++;
+                }
+                writtenPos = m_queue.getDequeuePos();
+
+                std::size_t dropped = m_dropped.load(std::memory_order_relaxed);
+                if (dropped != reportedDropped) {
+                    line = "[WARNING] Log: " + std::to_string(dropped - reportedDropped) + " records dropped, the queue was full\n";
+                    if (console) std::fwrite(line.data(), 1, line.size(), stderr);
+                    m_file.write(line.data(), line.size());
+                    reportedDropped = dropped;
+                }
+
+                if (written > 0) {
+                    std::fflush(stderr);
+                    m_file.flush();
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (written > 0) {
+                m_writtenCount += written;
+                m_writtenPos = writtenPos;
+                m_written.notify_all();
+            }
+
+            // Every record counted is popped once the counts match
+            m_sleeping.store(true);
+            if (m_queued.load() == m_writtenCount) {
+                if (m_stopping) break;
+                m_ready.wait_for(lock, LOG_WRITER_POLL, [this]() { return m_stopping || m_queued.load() != m_writtenCount; });
+            }
+            m_sleeping.store(false);
+        }
+    }
+
+    LogQueue m_queue;
+    std::atomic<std::size_t> m_queued{0};
+    std::atomic<std::size_t> m_dropped{0};
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_console{true};
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_written;
+    std::size_t m_writtenCount{0};     // records written, against m_queued to tell when to sleep
+    std::size_t m_writtenPos{0};       // queue positions written, for flush()
+    bool m_stopping{false};
+
+    std::mutex m_fileMutex;
+    RotatingFile m_file;
+
+    std::thread m_writer;
+};
+
+LogSink& getSink() {
+    static LogSink sink;
+    return sink;
+}
+
+} // namespace
+
+namespace Log {
+
+void write(LogLevel level, std::string context, std::string message) {
+    getSink().push({level, std::move(context), std::move(message)});
+}
+
+void flush() {
+    getSink().flush();
+}
+
+std::size_t getDroppedCount() {
+    return getSink().getDroppedCount();
+}
+
+bool setFileSink(const std::string& path, std::size_t maxBytes, int maxFiles) {
+    return getSink().setFile(path, maxBytes, maxFiles);
+}
+
+void setConsoleEnabled(bool enabled) {
+    getSink().setConsoleEnabled(enabled);
+}
+
+const char* getLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE:    return "TRACE";
+        case LogLevel::DEBUG:    return "DEBUG";
+        case LogLevel::INFO:     return "INFO";
+        case LogLevel::WARNING:  return "WARNING";
+        case LogLevel::ERROR:    return "ERROR";
+        case LogLevel::CRITICAL: return "CRITICAL";
+    }
+    return "";
+}
+
+} // namespace Log
+
+} // namespace DiveComputer
@@ -0,0 +1,68 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace DiveComputer {
+
+enum class LogLevel {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR,
+    CRITICAL
+};
+
+// Levels below this one are compiled out, message formatting included: 0 TRACE, 1 DEBUG, 2 INFO.
+// qmake CONFIG+=log_debug or CONFIG+=log_trace lowers it
+#ifndef DIVECOMPUTER_LOG_LEVEL
+#define DIVECOMPUTER_LOG_LEVEL 2
+#endif
+
+// Records of the levels compiled in go through a bounded lock-free queue to a background thread
+// writing them to stderr and an optional file, so the caller never waits on I/O
+namespace Log {
+    // Queues one record from any thread; dropped, and counted, when the queue is full. A
+    // CRITICAL record is never dropped: with the queue full, the calling thread waits for the
+    // records ahead of it, then writes it to stderr and the file itself
+    void write(LogLevel level, std::string context, std::string message);
+
+    // Waits until the records queued so far by any thread are written, the caller's included
+    void flush();
+
+    // Records dropped since start-up because the queue was full
+    std::size_t getDroppedCount();
+
+    // Also writes the records to path, moved to path.1 ... path.<maxFiles - 1> once it reaches
+    // maxBytes, the oldest being deleted. An empty path stops; false if the file cannot be opened
+    bool setFileSink(const std::string& path, std::size_t maxBytes = 1024 * 1024, int maxFiles = 3);
+
+    // Records go to stderr unless disabled
+    void setConsoleEnabled(bool enabled);
+
+    const char* getLevelName(LogLevel level);
+}
+
+} // namespace DiveComputer
+
+// message may chain stream insertions: DC_LOG_DEBUG("DivePlan", "depth " << depth)
+#define DC_LOG(level, context, message)                                                        \
+    do {                                                                                       \
+        if (static_cast<int>(level) >= DIVECOMPUTER_LOG_LEVEL) {                               \
+            std::ostringstream dcLogStream;                                                    \
+            dcLogStream << message;                                                            \
+            ::DiveComputer::Log::write(level, context, dcLogStream.str());                     \
+        }                                                                                      \
+    } while (0)
+
+#define DC_LOG_TRACE(context, message)    DC_LOG(::DiveComputer::LogLevel::TRACE, context, message)
+#define DC_LOG_DEBUG(context, message)    DC_LOG(::DiveComputer::LogLevel::DEBUG, context, message)
+#define DC_LOG_INFO(context, message)     DC_LOG(::DiveComputer::LogLevel::INFO, context, message)
+#define DC_LOG_WARNING(context, message)  DC_LOG(::DiveComputer::LogLevel::WARNING, context, message)
+#define DC_LOG_ERROR(context, message)    DC_LOG(::DiveComputer::LogLevel::ERROR, context, message)
+#define DC_LOG_CRITICAL(context, message) DC_LOG(::DiveComputer::LogLevel::CRITICAL, context, message)
+
+#endif // LOG_HPP
@@ -1,6 +1,7 @@
 
 #include "qtheaders.hpp"
 #include "main_gui.hpp"
+#include "error_dialog.hpp"
 
 int main(int argc, char *argv[]) {
     // Initialize QT Application
@@ -11,6 +12,9 @@ int main(int argc, char *argv[]) {
     QCoreApplication::setOrganizationName("DiveComputer");
     QCoreApplication::setApplicationName("DiveComputer");
 
+    // Engine errors are shown as message boxes in the GUI
+    DiveComputer::ErrorDialog::install();
+
     // Create and show main window
     DiveComputer::MainWindow mainWindow;
     mainWindow.show();
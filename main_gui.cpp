@@ -1,6 +1,7 @@
 #include "main_gui.hpp"
 #include "constants.hpp"
 #include "dive_plan_dialog.hpp"
+#include "trace.hpp"
 
 namespace DiveComputer {
 
@@ -41,6 +42,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 
     // Create File menu
     QMenu *fileMenu = QMainWindow::menuBar()->addMenu("File");
+    // Only builds with CONFIG+=trace record spans
+    if (Trace::isAvailable()) {
+        QAction *exportTraceAction = fileMenu->addAction("Export trace...");
+        connect(exportTraceAction, SIGNAL(triggered()), this, SLOT(exportTrace()));
+    }
     QAction *quitAction = fileMenu->addAction("Quit");
     quitAction->setShortcut(QKeySequence::Quit); // Cmd+Q on macOS
     // Connect to the application quit slot
@@ -133,6 +139,16 @@ void MainWindow::quitApplication() {
     close();
 }
 
+void MainWindow::exportTrace() {
+    QString fileName = QFileDialog::getSaveFileName(this, "Export trace", "divecomputer_trace.json",
+                                                    "Chrome trace (*.json)");
+    if (fileName.isEmpty()) return;
+
+    if (!Trace::writeChromeTrace(fileName.toStdString())) {
+        ErrorDialog::showErrorDialog("Export trace", "Could not write " + fileName, ErrorSeverity::ERROR);
+    }
+}
+
 bool MainWindow::eventFilter(QObject* obj, QEvent* event) {
     if (event->type() == QEvent::WindowActivate) {
         QWidget* activeWindow = QApplication::activeWindow();
@@ -63,6 +63,7 @@ private:
 private slots:
     void createDivePlan();
     void quitApplication();
+    void exportTrace();
     void openGasListWindow();
     void handleWindowDestroyed();
     void openParameterWindow();
@@ -1,11 +1,9 @@
 #include "oxygen_toxicity.hpp"
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 
 namespace DiveComputer {
 
-// Initialize global OxygenToxicity instance
-OxygenToxicity g_oxygenToxicity;
-
 O2Exposure::O2Exposure(double ppO2Start, double ppO2End, 
                      double aCNSMaxMinSingleDive, double bCNSMaxMinSingleDive,
                      double aCNSMaxMinMultipleDives, double bCNSMaxMinMultipleDives)
@@ -29,40 +27,98 @@ OxygenToxicity::OxygenToxicity() {
         O2Exposure(1.1, 1.5, -300, 570, -225, 517.5),
         O2Exposure(1.5, 1.65, -750, 1245, -300, 630)
     }};
+
+    // Sampled once; the CNS columns extend the end segments so interpolation near the bounds stays exact
+    int nbEntries = (int) std::lround(O2_TABLE_MAX / O2_TABLE_STEP) + 1;
+    m_table.resize(nbEntries);
+    for (int i = 0; i < nbEntries; i++) {
+        double ppO2 = i * O2_TABLE_STEP;
+        m_table[i] = { getCNSMaxMinFromSegments(ppO2, true),
+                       getCNSMaxMinFromSegments(ppO2, false),
+                       getOTUPerMinFromFormula(ppO2) };
+    }
 }
 
-double OxygenToxicity::getOTUPerMin(double ppO2Ambient) const {
+// Exposure limits beyond the NOAA table: no CNS accrual below it, practically unlimited time above it
+static const double CNS_MAX_MIN_ABOVE_TABLE = 100000.0;
+
+double OxygenToxicity::getOTUPerMinFromFormula(double ppO2Ambient) const {
     const double exponent = 0.833;
     
     return (ppO2Ambient >= 0.5) ? std::pow((ppO2Ambient - 0.5) / 0.5, exponent) : 0.0;
 }
 
+// Segment formula at ppO2Ambient, extended past the ends of the table
+double OxygenToxicity::getCNSMaxMinFromSegments(double ppO2Ambient, bool singleDive) const {
+    int i = 0;
+    while (i < NUM_O2_EXPOSURE_PARAMETERS - 1 && ppO2Ambient > m_o2ExposureParameters[i].m_ppO2End) {
+        i++;
+    }
+
+    const O2Exposure& segment = m_o2ExposureParameters[i];
+    return singleDive ? segment.m_aCNSMaxMinSingleDive * ppO2Ambient + segment.m_bCNSMaxMinSingleDive
+                      : segment.m_aCNSMaxMinMultipleDives * ppO2Ambient + segment.m_bCNSMaxMinMultipleDives;
+}
+
+OxygenToxicity::O2TableEntry OxygenToxicity::getTableEntry(double ppO2Ambient) const {
+    int last = (int) m_table.size() - 1;
+    double x = std::max(ppO2Ambient, 0.0) / O2_TABLE_STEP;
+    int i = std::min((int) x, last - 1);
+    double t = x - i;
+
+    const O2TableEntry& a = m_table[i];
+    const O2TableEntry& b = m_table[i + 1];
+    return { a.m_cnsMaxMinSingleDive + t * (b.m_cnsMaxMinSingleDive - a.m_cnsMaxMinSingleDive),
+             a.m_cnsMaxMinMultipleDives + t * (b.m_cnsMaxMinMultipleDives - a.m_cnsMaxMinMultipleDives),
+             a.m_otuPerMin + t * (b.m_otuPerMin - a.m_otuPerMin) };
+}
+
+double OxygenToxicity::getOTUPerMin(double ppO2Ambient) const {
+    if (ppO2Ambient >= O2_TABLE_MAX) {
+        return getOTUPerMinFromFormula(ppO2Ambient);
+    }
+    return getTableEntry(ppO2Ambient).m_otuPerMin;
+}
+
 double OxygenToxicity::getCNSMaxMin(double ppO2Ambient, bool singleDive) const {
-    double a = 0.0, b = 0.0;
-
-    if (ppO2Ambient >= m_o2ExposureParameters[0].m_ppO2Start) {
-        if (ppO2Ambient > m_o2ExposureParameters[NUM_O2_EXPOSURE_PARAMETERS - 1].m_ppO2End) {
-            std::cout << "WARNING: ppO2 is greater than the highest ppO2 value in the NOAA table for oxygen toxicity" << std::endl;
-            a = 0.0;
-            b = 100000.0;
-        } else {
-            for (int i = 0; i < NUM_O2_EXPOSURE_PARAMETERS; i++) {
-                if ((ppO2Ambient >= m_o2ExposureParameters[i].m_ppO2Start) && 
-                    (ppO2Ambient <= m_o2ExposureParameters[i].m_ppO2End)) {
-                    if (singleDive) {
-                        a = m_o2ExposureParameters[i].m_aCNSMaxMinSingleDive;
-                        b = m_o2ExposureParameters[i].m_bCNSMaxMinSingleDive;
-                    } else {
-                        a = m_o2ExposureParameters[i].m_aCNSMaxMinMultipleDives;
-                        b = m_o2ExposureParameters[i].m_bCNSMaxMinMultipleDives;
-                    }
-                    break;
-                }
-            }
-        }
+    if (ppO2Ambient < m_o2ExposureParameters[0].m_ppO2Start) {
+        return 0.0;
+    }
+    if (ppO2Ambient > m_o2ExposureParameters[NUM_O2_EXPOSURE_PARAMETERS - 1].m_ppO2End) {
+        return CNS_MAX_MIN_ABOVE_TABLE;
+    }
+
+    O2TableEntry entry = getTableEntry(ppO2Ambient);
+    return singleDive ? entry.m_cnsMaxMinSingleDive : entry.m_cnsMaxMinMultipleDives;
+}
+
+O2Dose OxygenToxicity::getDose(const double* ppO2, const double* time, std::size_t count) const {
+    double cnsStart = m_o2ExposureParameters[0].m_ppO2Start;
+    double cnsEnd = m_o2ExposureParameters[NUM_O2_EXPOSURE_PARAMETERS - 1].m_ppO2End;
+    int last = (int) m_table.size() - 1;
+    const O2TableEntry* table = m_table.data();
+
+    O2Dose dose;
+    for (std::size_t k = 0; k < count; k++) {
+        double p = ppO2[k];
+        double x = std::min(std::max(p, 0.0), O2_TABLE_MAX) / O2_TABLE_STEP;
+        int i = std::min((int) x, last - 1);
+        double t = x - i;
+
+        const O2TableEntry& a = table[i];
+        const O2TableEntry& b = table[i + 1];
+        double cnsSingle = a.m_cnsMaxMinSingleDive + t * (b.m_cnsMaxMinSingleDive - a.m_cnsMaxMinSingleDive);
+        double cnsMultiple = a.m_cnsMaxMinMultipleDives + t * (b.m_cnsMaxMinMultipleDives - a.m_cnsMaxMinMultipleDives);
+        double otu = (p < O2_TABLE_MAX) ? a.m_otuPerMin + t * (b.m_otuPerMin - a.m_otuPerMin) : getOTUPerMinFromFormula(p);
+
+        // Same limits as getCNSMaxMin(): none below the NOAA table, practically none above it
+        bool inTable = (p >= cnsStart && p <= cnsEnd);
+        dose.m_cnsSingleDive += inTable ? 100.0 * time[k] / cnsSingle : (p > cnsEnd ? 100.0 * time[k] / CNS_MAX_MIN_ABOVE_TABLE : 0.0);
+        dose.m_cnsMultipleDives += inTable ? 100.0 * time[k] / cnsMultiple : (p > cnsEnd ? 100.0 * time[k] / CNS_MAX_MIN_ABOVE_TABLE : 0.0);
+        dose.m_otu += time[k] * otu;
     }
 
-    return a * ppO2Ambient + b;
+    return dose;
 }
 
 } // namespace DiveComputer
@@ -2,6 +2,8 @@
 #define OXYGEN_TOXICITY_HPP
 
 #include <array>
+#include <cstddef>
+#include <vector>
 
 namespace DiveComputer {
 
@@ -26,6 +28,13 @@ public:
 };
 
 
+// Oxygen dose of a run of segments
+struct O2Dose {
+    double m_cnsSingleDive{0.0};      // % of the single dive limit
+    double m_cnsMultipleDives{0.0};   // % of the multiple dives limit
+    double m_otu{0.0};
+};
+
 class OxygenToxicity {
 public:
     OxygenToxicity();
@@ -37,14 +46,30 @@ public:
     // Calculate CNS max minutes (single_dive or multiple_dives)
     double getCNSMaxMin(double ppO2Ambient, bool singleDive) const;
 
+    // Dose of count segments of time[i] minutes at ppO2[i], in a single pass over the table
+    O2Dose getDose(const double* ppO2, const double* time, std::size_t count) const;
+
 private:
     // NOAA table linearized in the form of CNS_total = a * ppO2 + b
     static constexpr int NUM_O2_EXPOSURE_PARAMETERS = 6;
     std::array<O2Exposure, NUM_O2_EXPOSURE_PARAMETERS> m_o2ExposureParameters;
-};
 
-// Global instance - will be defined in oxygen_toxicity.cpp
-extern OxygenToxicity g_oxygenToxicity;
+    // Lookup table sampled every O2_TABLE_STEP bar up to O2_TABLE_MAX, read by linear interpolation.
+    // The step divides the NOAA segment bounds, so the CNS limits interpolate exactly
+    static constexpr double O2_TABLE_STEP = 0.0025;
+    static constexpr double O2_TABLE_MAX = 4.0;
+
+    struct O2TableEntry {
+        double m_cnsMaxMinSingleDive;
+        double m_cnsMaxMinMultipleDives;
+        double m_otuPerMin;
+    };
+    std::vector<O2TableEntry> m_table;
+
+    double getCNSMaxMinFromSegments(double ppO2Ambient, bool singleDive) const;
+    double getOTUPerMinFromFormula(double ppO2Ambient) const;
+    O2TableEntry getTableEntry(double ppO2Ambient) const;
+};
 
 } // namespace DiveComputer
 
@@ -1,4 +1,5 @@
 #include "parameters.hpp"
+#include "log.hpp"
 
 namespace DiveComputer {
 
@@ -9,8 +10,6 @@ Parameters::Parameters() {
     // Set to Delfult
     setToDefault();
 
-    // Ensure app info is set before any path operations
-    ensureAppInfoSet();
     loadParametersFromFile();
 }
 
@@ -49,15 +48,15 @@ void Parameters::setToDefault() {
 bool Parameters::loadParametersFromFile() {
     const std::string filename = getFilePath(PARAMETERS_FILE_NAME);
     
-    std::cout << "Trying to load parameters from: " << filename << std::endl;
+    DC_LOG_DEBUG("Parameters", "Trying to load parameters from: " << filename);
     
     // Try to load parameters from file if it exists
     if (std::filesystem::exists(filename)) {
-        std::cout << "Parameters file exists, loading it..." << std::endl;
+        DC_LOG_DEBUG("Parameters", "Parameters file exists, loading it...");
         
         std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) {
-            std::cerr << "Failed to open parameters file for reading." << std::endl;
+            DC_LOG_ERROR("Parameters", "Failed to open parameters file for reading.");
             return false;
         } else {
             try {
@@ -91,17 +90,17 @@ bool Parameters::loadParametersFromFile() {
                 file.read(reinterpret_cast<char*>(&m_noFlyTimeIncrement), sizeof(m_noFlyTimeIncrement));
                 
                 file.close();
-                std::cout << "Parameters loaded successfully." << std::endl;
+                DC_LOG_DEBUG("Parameters", "Parameters loaded successfully.");
                 return true;
             }
             catch (const std::exception& e) {
-                std::cerr << "Exception while reading parameters: " << e.what() << std::endl;
+                DC_LOG_ERROR("Parameters", "Exception while reading parameters: " << e.what());
                 file.close();
                 return false;
             }
         }
     } else {
-        std::cout << "Parameters file does not exist at " << filename << ". Using default values." << std::endl;
+        DC_LOG_INFO("Parameters", "Parameters file does not exist at " << filename << ". Using default values.");
         
         // Since file doesn't exist, let's try saving default values to establish the file
         saveParametersToFile();
@@ -113,7 +112,7 @@ bool Parameters::loadParametersFromFile() {
 bool Parameters::saveParametersToFile() {
     const std::string filename = getFilePath(PARAMETERS_FILE_NAME);
     
-    std::cout << "Saving parameters to: " << filename << std::endl;
+    DC_LOG_DEBUG("Parameters", "Saving parameters to: " << filename);
     
     // Create directories if they don't exist
     std::filesystem::path filePath(filename);
@@ -121,7 +120,7 @@ bool Parameters::saveParametersToFile() {
     
     std::ofstream file(filename, std::ios::binary | std::ios::trunc);
     if (!file.is_open()) {
-        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        DC_LOG_ERROR("Parameters", "Failed to open file for writing: " << filename);
         return false;
     }
 
@@ -158,11 +157,11 @@ bool Parameters::saveParametersToFile() {
     
     // Verify the file was created
     if (std::filesystem::exists(filename)) {
-        std::cout << "Parameters saved successfully to " << filename << ". File size: " 
-                  << std::filesystem::file_size(filename) << " bytes" << std::endl;
+        DC_LOG_DEBUG("Parameters", "Parameters saved successfully to " << filename << ". File size: "
+                     << std::filesystem::file_size(filename) << " bytes");
         return true;
     } else {
-        std::cerr << "Error: File does not exist after save operation!" << std::endl;
+        DC_LOG_ERROR("Parameters", "File does not exist after save operation!");
         return false;
     }
 }
@@ -3,6 +3,7 @@
 
 #include "qtheaders.hpp"
 #include "parameters.hpp"
+#include "ui_utils.hpp"
 
 namespace DiveComputer {
 
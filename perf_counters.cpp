@@ -0,0 +1,16 @@
+#include "perf_counters.hpp"
+
+namespace DiveComputer {
+
+// Constant-initialised, so usable from operator new at any point of a thread's life
+static thread_local unsigned long long t_allocations = 0;
+
+unsigned long long getThreadAllocationCount() {
+    return t_allocations;
+}
+
+void countThreadAllocation() {
+    t_allocations++;
+}
+
+} // namespace DiveComputer
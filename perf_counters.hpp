@@ -0,0 +1,16 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+namespace DiveComputer {
+
+// Heap allocations made by the calling thread since it started. The engine leaves the process
+// allocator alone: a program that wants the count replaces the global operator new and calls
+// countThreadAllocation() from it, as dive_benchmark does. Elsewhere it stays at 0
+unsigned long long getThreadAllocationCount();
+
+// Adds one to the calling thread's count; a thread-local increment, safe from operator new
+void countThreadAllocation();
+
+} // namespace DiveComputer
+
+#endif // PERF_COUNTERS_HPP
@@ -3,6 +3,7 @@
 
 #include "qtheaders.hpp"
 #include "global.hpp"
+#include "ui_utils.hpp"
 
 namespace DiveComputer {
 
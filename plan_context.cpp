@@ -0,0 +1,54 @@
+#include "plan_context.hpp"
+#include "gaslist.hpp"
+
+namespace DiveComputer {
+
+PlanContext::PlanContext(const Parameters& parameters, const std::vector<Gas>& gases, const SetPoints& setPoints)
+    : m_parameters(parameters)
+    , m_gases(gases)
+    , m_setPoints(setPoints)
+{
+    // Density and END coefficients follow these parameters, whatever the gases were built with
+    for (Gas& gas : m_gases) {
+        gas.m_properties = GasProperties(gas.m_o2Percent, gas.m_hePercent, m_parameters);
+    }
+
+    // Filled once here; lookups are read-only afterwards so the context can be shared across threads
+    m_buhlmannModel.prepareDecayCache(getDecayCacheDurations());
+}
+
+std::shared_ptr<const PlanContext> PlanContext::fromGlobals() {
+    return fromGlobals(g_setPoints);
+}
+
+std::shared_ptr<const PlanContext> PlanContext::fromGlobals(const SetPoints& setPoints) {
+    return std::make_shared<const PlanContext>(g_parameters, g_gasList.getGases(), setPoints);
+}
+
+double PlanContext::getMaxPpO2(stepMode mode) const {
+    switch (mode) {
+        case stepMode::OC:
+        case stepMode::BAILOUT:
+            return m_parameters.m_PpO2Active;
+        case stepMode::DECO:
+            return m_parameters.m_PpO2Deco;
+        case stepMode::CC:
+            return m_parameters.m_maxPpO2Diluent;
+        default:
+            return m_parameters.m_PpO2Active;
+    }
+}
+
+std::vector<double> PlanContext::getDecayCacheDurations() const {
+    // Zero-time steps, gas switches, the deco and max-time increments, and ascents between stops
+    return {
+        0.0,
+        GAS_SWITCH_TIME,
+        m_parameters.m_timeIncrementDeco,
+        m_parameters.m_timeIncrementMaxTime,
+        m_parameters.m_depthIncrement / m_parameters.m_maxAscentRate,
+        m_parameters.m_lastStopDepth / m_parameters.m_maxAscentRate
+    };
+}
+
+} // namespace DiveComputer
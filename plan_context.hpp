@@ -0,0 +1,47 @@
+#ifndef PLAN_CONTEXT_HPP
+#define PLAN_CONTEXT_HPP
+
+#include <memory>
+#include <vector>
+#include "enum.hpp"
+#include "parameters.hpp"
+#include "buhlmann.hpp"
+#include "oxygen_toxicity.hpp"
+#include "gas.hpp"
+#include "set_points.hpp"
+
+namespace DiveComputer {
+
+// Duration of the step inserted at each gas switch, in minutes
+const double GAS_SWITCH_TIME = 0.01;
+
+// Immutable snapshot of everything a plan reads besides its own steps.
+// Shared as std::shared_ptr<const PlanContext>, so plans with different settings
+// can be calculated on different threads without touching the process globals
+class PlanContext {
+public:
+    PlanContext(const Parameters& parameters, const std::vector<Gas>& gases, const SetPoints& setPoints);
+    ~PlanContext() = default;
+
+    // Snapshot of g_parameters, g_gasList and g_setPoints
+    static std::shared_ptr<const PlanContext> fromGlobals();
+
+    // Same, keeping the setpoints already edited on a plan
+    static std::shared_ptr<const PlanContext> fromGlobals(const SetPoints& setPoints);
+
+    Parameters     m_parameters;
+    BuhlmannModel  m_buhlmannModel;     // decay cache filled for the step durations of these parameters
+    OxygenToxicity m_oxygenToxicity;
+    std::vector<Gas> m_gases;           // gas inventory, seeds DivePlan::m_gasAvailable
+    SetPoints      m_setPoints;         // seeds DivePlan::m_setPoints
+
+    // Max ppO2 used to pick the gas of a step in this mode
+    double getMaxPpO2(stepMode mode) const;
+
+private:
+    std::vector<double> getDecayCacheDurations() const;
+};
+
+} // namespace DiveComputer
+
+#endif // PLAN_CONTEXT_HPP
@@ -1,17 +1,18 @@
 #include "set_points.hpp"
+#include <algorithm>
 
 namespace DiveComputer {
 
+// Define the global SetPoints instance
+SetPoints g_setPoints;
+
 SetPoints::SetPoints() {
-    // Ensure app info is set before any path operations
-    ensureAppInfoSet();
 
     // Try to load from file
     if (!loadSetPointsFromFile()) {
         m_setPoints.clear();
         setToDefault();
     }
-    sortSetPoints();
 }
 
 void SetPoints::setToDefault() {
@@ -21,78 +22,51 @@ void SetPoints::setToDefault() {
     addSetPoint(6.0, 1.6);
 }
 
-// Sort the setpoints by decreasing depth, then decreasing setpoint
-void SetPoints::sortSetPoints() {
-    // Sort the depths and setpoints in descending order
-    std::vector<double> sortedDepths;
-    std::vector<double> sortedSetPoints;
-
-    // Create a vector of pairs of depths and setpoints
-    std::vector<std::pair<double, double>> depthSetpoints;
-    for (size_t i = 0; i < m_depths.size(); ++i) {
-        depthSetpoints.push_back(std::make_pair(m_depths[i], m_setPoints[i]));
-    }   
-
-    // Sort the vector of pairs by decreasing depth, then decreasing setpoint
-    std::sort(depthSetpoints.begin(), depthSetpoints.end(), [](const std::pair<double, double>& a, const std::pair<double, double>& b) {
-        if (a.first == b.first) {
-            return a.second > b.second;
-        }
-        return a.first > b.first;
-    });
-
-    // Extract the sorted depths and setpoints
-    for (const auto& pair : depthSetpoints) {
-        sortedDepths.push_back(pair.first);
-        sortedSetPoints.push_back(pair.second);
+// Order of the schedule: decreasing depth, then decreasing setpoint
+static bool isBefore(const SetPoint& a, const SetPoint& b) {
+    if (a.m_depth == b.m_depth) {
+        return a.m_setPoint > b.m_setPoint;
     }
-
-    // Update the member variables with the sorted values
-    m_depths = sortedDepths;
-    m_setPoints = sortedSetPoints;  
+    return a.m_depth > b.m_depth;
 }
 
 // Find the setpoint at a given depth
-double SetPoints::getSetPointAtDepth(double depth, bool boosted) {
-    // First, ensure setpoints are sorted by decreasing depth, then decreasing setpoint
-    sortSetPoints();
-    
-    // If no setpoints defined, return a default value (Diluent max PpO2)
-    if (m_depths.empty()) {
-        return g_parameters.m_maxPpO2Diluent;
+double SetPoints::getSetPointAtDepth(double depth, bool boosted, double defaultSetPoint) const {
+    // If no setpoints defined, return the default value (Diluent max PpO2)
+    if (m_setPoints.empty()) {
+        return defaultSetPoint;
     }
-    
+
     // Case A: If depth is greater than or equal to the deepest setpoint
-    if ((depth >= m_depths[0]) || !boosted){
-        return m_setPoints[0]; // Return the setpoint for deepest depth
+    if ((depth >= m_setPoints.front().m_depth) || !boosted) {
+        return m_setPoints.front().m_setPoint; // Return the setpoint for deepest depth
     }
-    
+
     // Case B: If depth is less than the shallowest setpoint
-    if (depth < m_depths[m_depths.size() - 1]) {
-        return m_setPoints[m_depths.size() - 1]; // Return the shallowest setpoint
+    if (depth < m_setPoints.back().m_depth) {
+        return m_setPoints.back().m_setPoint; // Return the shallowest setpoint
     }
-    
-    // Case C: Depth is between deepest and shallowest setpoints
-    // Find the setpoint with the depth immediately greater than the target depth
-    for (size_t i = 0; i < m_depths.size() - 1; i++) {
-        if (depth < m_depths[i] && depth >= m_depths[i + 1]) {
-            return m_setPoints[i]; // Return the setpoint with depth immediately greater
-        }
-    }
-    
-    // Fallback (should not reach here if all cases are covered properly)
-    return m_setPoints[0];
+
+    // Case C: the entry just before the first one at or above depth
+    auto next = std::partition_point(m_setPoints.begin(), m_setPoints.end(),
+                                     [depth](const SetPoint& setPoint) { return setPoint.m_depth > depth; });
+    return (next - 1)->m_setPoint;
 }
 
 void SetPoints::addSetPoint(double depth, double setpoint) {
-    m_depths.push_back(depth);
-    m_setPoints.push_back(setpoint);
-    sortSetPoints();
+    SetPoint setPoint{depth, setpoint};
+    m_setPoints.insert(std::upper_bound(m_setPoints.begin(), m_setPoints.end(), setPoint, isBefore), setPoint);
+}
+
+void SetPoints::editSetPoint(size_t index, double depth, double setpoint) {
+    if (index < m_setPoints.size()) {
+        m_setPoints.erase(m_setPoints.begin() + index);
+        addSetPoint(depth, setpoint);
+    }
 }
 
 void SetPoints::removeSetPoint(size_t index) {
-    if (index < m_depths.size()) {
-        m_depths.erase(m_depths.begin() + index);
+    if (index < m_setPoints.size()) {
         m_setPoints.erase(m_setPoints.begin() + index);
     }
 }
@@ -114,7 +88,6 @@ bool SetPoints::loadSetPointsFromFile() {
         }
         
         // Clear existing setpoints
-        m_depths.clear();
         m_setPoints.clear();
         
         // Read number of setpoints
@@ -122,7 +95,6 @@ bool SetPoints::loadSetPointsFromFile() {
         file.read(reinterpret_cast<char*>(&count), sizeof(count));
         
         // Reserve space
-        m_depths.reserve(count);
         m_setPoints.reserve(count);
         
         // Read each setpoint
@@ -137,15 +109,13 @@ bool SetPoints::loadSetPointsFromFile() {
                 throw std::ios_base::failure("Error reading setpoint data");
             }
             
-            // Add to vectors
-            m_depths.push_back(depth);
-            m_setPoints.push_back(setPoint);
+            m_setPoints.push_back({depth, setPoint});
         }
         
         file.close();
         
-        // Sort setpoints
-        sortSetPoints();
+        // Sort once, lookups rely on the order
+        std::sort(m_setPoints.begin(), m_setPoints.end(), isBefore);
         
         ErrorHandler::logError("SetPoints", "Loaded " + std::to_string(count) + 
                              " setpoints successfully", ErrorSeverity::INFO);
@@ -166,13 +136,13 @@ bool SetPoints::saveSetPointsToFile() {
         }
         
         // Write number of setpoints
-        size_t count = m_depths.size();
+        size_t count = m_setPoints.size();
         file.write(reinterpret_cast<const char*>(&count), sizeof(count));
         
         // Write each setpoint
         for (size_t i = 0; i < count; ++i) {
-            file.write(reinterpret_cast<const char*>(&m_depths[i]), sizeof(m_depths[i]));
-            file.write(reinterpret_cast<const char*>(&m_setPoints[i]), sizeof(m_setPoints[i]));
+            file.write(reinterpret_cast<const char*>(&m_setPoints[i].m_depth), sizeof(m_setPoints[i].m_depth));
+            file.write(reinterpret_cast<const char*>(&m_setPoints[i].m_setPoint), sizeof(m_setPoints[i].m_setPoint));
             
             if (file.fail()) {
                 throw std::ios_base::failure("Error writing setpoint data");
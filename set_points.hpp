@@ -3,30 +3,45 @@
 
 #include "global.hpp"
 #include "error_handler.hpp"
+#include <vector>
 
 namespace DiveComputer {
 
+// Setpoint used from m_depth up to the next shallower entry of the schedule
+struct SetPoint {
+    double m_depth;
+    double m_setPoint;
+};
+
 class SetPoints {
 public:
     SetPoints();
 
-    // Attributes
-    std::vector<double> m_depths;
-    std::vector<double> m_setPoints;
+    // Schedule sorted by decreasing depth, then decreasing setpoint; every modifier keeps it sorted
+    const std::vector<SetPoint>& getSetPoints() const { return m_setPoints; }
+    const SetPoint& getSetPoint(size_t index) const { return m_setPoints[index]; }
+    size_t nbOfSetPoints() const { return m_setPoints.size(); }
+
+    // Binary search, no allocation
+    double getSetPointAtDepth(double depth, bool boosted, double defaultSetPoint) const;
 
-    // Methods  
-    double getSetPointAtDepth(double depth, bool boosted);
+    // Modifiers
+    void addSetPoint(double depth, double setpoint);
+    void editSetPoint(size_t index, double depth, double setpoint);
+    void removeSetPoint(size_t index);
 
     // File operations
     void setToDefault();
     bool loadSetPointsFromFile();
     bool saveSetPointsToFile();
-    void sortSetPoints();
-    size_t nbOfSetPoints() const { return m_depths.size(); }
-    void addSetPoint(double depth, double setpoint);
-    void removeSetPoint(size_t index);
+
+private:
+    std::vector<SetPoint> m_setPoints;
 };
 
+// Saved schedule, loaded once at start-up; the front-end keeps it in step with what it saves
+extern SetPoints g_setPoints;
+
 } // namespace DiveComputer
 
 #endif
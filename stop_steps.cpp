@@ -1,4 +1,5 @@
 #include "stop_steps.hpp"
+#include <algorithm>
 
 namespace DiveComputer {
 
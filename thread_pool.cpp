@@ -0,0 +1,193 @@
+#include "thread_pool.hpp"
+#include "error_handler.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace DiveComputer {
+
+// Identifies the pool and deque owned by the current thread, if it is a worker
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local int t_workerIndex = -1;
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    threadCount = std::max(threadCount, 1u);
+
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_all();
+
+    // Workers drain their queues before leaving
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+int ThreadPool::currentWorkerIndex() const {
+    return (t_pool == this) ? t_workerIndex : -1;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int worker = currentWorkerIndex();
+    unsigned int queueIndex = (worker >= 0) ? (unsigned int) worker
+                                            : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    m_pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->m_mutex);
+        m_queues[queueIndex]->m_tasks.push_back(std::move(task));
+    }
+    m_queued.fetch_add(1);
+
+    // Taking the lock orders the count update with a worker about to sleep
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_wakeUp.notify_one();
+}
+
+bool ThreadPool::popTask(int preferredQueue, std::function<void()>& task) {
+    int nbQueues = (int) m_queues.size();
+
+    // Own deque first, newest task: its data is most likely still in cache
+    if (preferredQueue >= 0) {
+        WorkQueue& queue = *m_queues[preferredQueue];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_tasks.empty()) {
+            task = std::move(queue.m_tasks.back());
+            queue.m_tasks.pop_back();
+            m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    int start = (preferredQueue >= 0) ? preferredQueue + 1 : 0;
+    for (int i = 0; i < nbQueues; i++) {
+        int victim = (start + i) % nbQueues;
+        if (victim == preferredQueue) continue;
+
+        WorkQueue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_tasks.empty()) {
+            task = std::move(queue.m_tasks.front());
+            queue.m_tasks.pop_front();
+            m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runTask(std::function<void()>& task) {
+    try {
+        task();
+    }
+    catch (const std::exception& e) {
+        ErrorHandler::logError("ThreadPool", e.what());
+    }
+    catch (...) {
+        ErrorHandler::logError("ThreadPool", "Unknown error occurred");
+    }
+    task = nullptr;
+
+    if (m_pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+    t_pool = this;
+    t_workerIndex = (int) index;
+
+    std::function<void()> task;
+    while (true) {
+        if (popTask((int) index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait(lock, [this]() { return m_stopping || m_queued.load() > 0; });
+        if (m_stopping && m_queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    // Help with the queued work, then sleep until the running tasks are done
+    std::function<void()> task;
+    while (popTask(currentWorkerIndex(), task)) {
+        runTask(task);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending.load() == 0; });
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body, std::size_t grainSize) {
+    if (count == 0) return;
+    grainSize = std::max<std::size_t>(grainSize, 1);
+
+    struct ForState {
+        std::atomic<std::size_t> m_remaining{0};
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        std::exception_ptr m_error;
+    };
+
+    auto state = std::make_shared<ForState>();
+    std::size_t nbChunks = (count + grainSize - 1) / grainSize;
+    state->m_remaining = nbChunks;
+
+    for (std::size_t chunk = 0; chunk < nbChunks; chunk++) {
+        std::size_t begin = chunk * grainSize;
+        std::size_t end = std::min(begin + grainSize, count);
+
+        submit([state, &body, begin, end]() {
+            try {
+                for (std::size_t i = begin; i < end; i++) {
+                    body(i);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(state->m_mutex);
+                if (!state->m_error) state->m_error = std::current_exception();
+            }
+
+            if (state->m_remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(state->m_mutex);
+                state->m_done.notify_all();
+            }
+        });
+    }
+
+    // Run chunks on this thread too instead of blocking a worker
+    std::function<void()> task;
+    while (state->m_remaining.load() > 0) {
+        if (popTask(currentWorkerIndex(), task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state->m_mutex);
+        state->m_done.wait(lock, [&state]() { return state->m_remaining.load() == 0; });
+    }
+
+    if (state->m_error) {
+        std::rethrow_exception(state->m_error);
+    }
+}
+
+} // namespace DiveComputer
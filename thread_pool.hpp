@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DiveComputer {
+
+// Work-stealing thread pool: each worker owns a deque, runs its own tasks newest first
+// and steals the oldest task of another worker when it runs dry
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return (unsigned int) m_threads.size(); }
+
+    // Queue a task; from inside a worker it goes to that worker's own deque
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has finished
+    void wait();
+
+    // Run body(i) for every i in [0, count) in chunks of grainSize and return when all are done.
+    // The calling thread runs queued work while waiting, so nested calls from a worker are safe.
+    // The first exception thrown by body is rethrown here
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body, std::size_t grainSize = 1);
+
+private:
+    struct WorkQueue {
+        std::mutex m_mutex;
+        std::deque<std::function<void()>> m_tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;        // tasks queued or stopping
+    std::condition_variable m_idle;          // all tasks finished
+    std::atomic<std::size_t> m_queued{0};    // tasks waiting in a deque
+    std::atomic<std::size_t> m_pending{0};   // tasks queued or running
+    std::atomic<unsigned int> m_nextQueue{0};
+    bool m_stopping{false};
+
+    void workerLoop(unsigned int index);
+    bool popTask(int preferredQueue, std::function<void()>& task);
+    void runTask(std::function<void()>& task);
+    int  currentWorkerIndex() const;
+};
+
+} // namespace DiveComputer
+
+#endif // THREAD_POOL_HPP
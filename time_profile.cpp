@@ -0,0 +1,100 @@
+#include "time_profile.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace DiveComputer {
+
+// CNS and OTU of one sample of a step, in % and OTU
+static double getCnsPerSample(double cnsMaxMin, double timeIncrement) {
+    return (cnsMaxMin != 0) ? 100 * timeIncrement / cnsMaxMin : 0;
+}
+
+TimeProfile::TimeProfile(const std::vector<DiveStep>& steps, std::shared_ptr<const PlanContext> context)
+    : m_steps(&steps)
+    , m_context(std::move(context))
+{
+    if (steps.empty()) return;
+
+    m_timeIncrement = m_context->m_parameters.m_timeIncrementDeco;
+    m_startTime = steps[0].m_runTime;
+    m_size = (int) std::floor((steps.back().m_runTime - m_startTime) / m_timeIncrement + 1e-9);
+
+    int nbSteps = (int) steps.size();
+    m_firstSample.resize(nbSteps + 1);
+    m_cnsSingleDiveBefore.resize(nbSteps + 1);
+    m_cnsMultipleDivesBefore.resize(nbSteps + 1);
+    m_otuBefore.resize(nbSteps + 1);
+
+    // Samples fall in the step with start < run time <= end; totals grow by one sample's worth each
+    m_firstSample[0] = 0;
+    for (int i = 0; i < nbSteps; i++) {
+        int next = (int) std::floor((steps[i].m_runTime - m_startTime) / m_timeIncrement + 1e-9);
+        m_firstSample[i + 1] = std::clamp(next, m_firstSample[i], m_size);
+
+        int nbSamples = m_firstSample[i + 1] - m_firstSample[i];
+        m_cnsSingleDiveBefore[i + 1] = m_cnsSingleDiveBefore[i] + nbSamples * getCnsPerSample(steps[i].m_cnsMaxMinSingleDive, m_timeIncrement);
+        m_cnsMultipleDivesBefore[i + 1] = m_cnsMultipleDivesBefore[i] + nbSamples * getCnsPerSample(steps[i].m_cnsMaxMinMultipleDives, m_timeIncrement);
+        m_otuBefore[i + 1] = m_otuBefore[i] + nbSamples * m_timeIncrement * steps[i].m_otuPerMin;
+    }
+}
+
+double TimeProfile::getRunTime(int index) const {
+    return m_startTime + (index + 1) * m_timeIncrement;
+}
+
+int TimeProfile::getStepIndex(int index) const {
+    // Last step whose first sample is at or before index, skipping the steps without samples
+    auto next = std::upper_bound(m_firstSample.begin(), m_firstSample.end() - 1, index);
+    return (int) (next - m_firstSample.begin()) - 1;
+}
+
+const DiveStep& TimeProfile::at(int index) {
+    if (index != m_sampleIndex) {
+        getSample(index, (index == m_sampleIndex + 1) ? &m_sample : nullptr, m_sample);
+        m_sampleIndex = index;
+    }
+    return m_sample;
+}
+
+void TimeProfile::getSample(int index, const DiveStep* previous, DiveStep& sample) const {
+    const std::vector<DiveStep>& steps = *m_steps;
+    const PlanContext& context = *m_context;
+
+    int stepIndex = getStepIndex(index);
+    const DiveStep& step = steps[stepIndex];
+    double runTime = getRunTime(index);
+    double stepStartTime = step.m_runTime - step.m_time;
+
+    // Tissues follow on from the previous sample of the same step, or from the end of the previous step.
+    // Copied first: previous may be sample itself
+    bool inOrder = (previous != nullptr) && (index > m_firstSample[stepIndex]);
+    double fromTime = inOrder ? runTime - m_timeIncrement : stepStartTime;
+    TissueState from = inOrder ? previous->m_ppActual : steps[stepIndex - 1].m_ppActual;
+
+    sample = step;
+
+    // Only adjusts the values which are dependant on time
+    sample.m_time = m_timeIncrement;
+    sample.m_runTime = runTime;
+    sample.m_stepConsumption = sample.m_ambConsumptionAtDepth * m_timeIncrement;
+
+    int nbSamples = index - m_firstSample[stepIndex] + 1;
+    sample.m_cnsStepSingleDive = getCnsPerSample(step.m_cnsMaxMinSingleDive, m_timeIncrement);
+    sample.m_cnsTotalSingleDive = m_cnsSingleDiveBefore[stepIndex] + nbSamples * sample.m_cnsStepSingleDive;
+    sample.m_cnsStepMultipleDives = getCnsPerSample(step.m_cnsMaxMinMultipleDives, m_timeIncrement);
+    sample.m_cnsTotalMultipleDives = m_cnsMultipleDivesBefore[stepIndex] + nbSamples * sample.m_cnsStepMultipleDives;
+    sample.m_otuStep = m_timeIncrement * step.m_otuPerMin;
+    sample.m_otuTotal = m_otuBefore[stepIndex] + nbSamples * sample.m_otuStep;
+
+    // Ambient pressure is linear in time within a step; samples one increment apart reuse the cached decay
+    double pAmbRate = (step.m_time == 0) ? 0 : (step.m_pAmbEndDepth - step.m_pAmbStartDepth) / step.m_time;
+    SchreinerDecay scratch;
+    applySchreiner(from, sample.m_ppActual, context.m_buhlmannModel.getDecay(runTime - fromTime, scratch),
+                   step.m_pAmbStartDepth + pAmbRate * (fromTime - stepStartTime),
+                   step.m_pAmbStartDepth + pAmbRate * (runTime - stepStartTime),
+                   step.m_n2Percent, step.m_hePercent);
+
+    sample.updateGFSurface(&steps.back(), context);
+}
+
+} // namespace DiveComputer
@@ -0,0 +1,86 @@
+#ifndef TIME_PROFILE_HPP
+#define TIME_PROFILE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "dive_step.hpp"
+#include "plan_context.hpp"
+
+namespace DiveComputer {
+
+// Samples of a plan every deco time increment, generated on demand from its steps instead of stored.
+// A sample is the step it falls in with the time dependent values (run time, tissues, consumption,
+// CNS, OTU, GF surface) brought to the sample time. Reading in order costs one cached Schreiner
+// update per sample, a random read one uncached update.
+// The view reads the plan's steps: it is invalid once the plan is calculated again
+class TimeProfile {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = DiveStep;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const DiveStep*;
+        using reference         = const DiveStep&;
+
+        Iterator(TimeProfile* profile, int index) : m_profile(profile), m_index(index) {}
+
+        reference operator*() const { return m_profile->at(m_index); }
+        pointer   operator->() const { return &m_profile->at(m_index); }
+        Iterator& operator++() { m_index++; return *this; }
+        bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        TimeProfile* m_profile;
+        int m_index;
+    };
+
+    TimeProfile() = default;
+    TimeProfile(const std::vector<DiveStep>& steps, std::shared_ptr<const PlanContext> context);
+
+    int    size() const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+    double getRunTime(int index) const;
+
+    // Index of the step sample index falls in, and that step
+    int getStepIndex(int index) const;
+    const DiveStep& getStep(int stepIndex) const { return (*m_steps)[stepIndex]; }
+    int nbOfSteps() const { return (int) m_firstSample.size() - 1; }
+    int getFirstSample(int stepIndex) const { return m_firstSample[stepIndex]; }
+
+    // Sample index; the reference stays valid until the next read from this view
+    const DiveStep& at(int index);
+
+    // Sample index written to sample, carried forward from previous when it is sample index - 1.
+    // Unlike at(), safe to call from several threads with their own buffers
+    void getSample(int index, const DiveStep* previous, DiveStep& sample) const;
+
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end()   { return Iterator(this, m_size); }
+
+private:
+    const std::vector<DiveStep>* m_steps{nullptr};
+    std::shared_ptr<const PlanContext> m_context;
+
+    double m_startTime{0.0};
+    double m_timeIncrement{1.0};
+    int    m_size{0};
+
+    // Per step: index of its first sample, and the running totals before it
+    std::vector<int>    m_firstSample;
+    std::vector<double> m_cnsSingleDiveBefore;
+    std::vector<double> m_cnsMultipleDivesBefore;
+    std::vector<double> m_otuBefore;
+
+    // Last sample generated, the start point of the next one when read in order
+    DiveStep m_sample;
+    int      m_sampleIndex{-1};
+};
+
+} // namespace DiveComputer
+
+#endif // TIME_PROFILE_HPP
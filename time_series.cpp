@@ -0,0 +1,95 @@
+#include "time_series.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace DiveComputer {
+
+static bool isSameRun(const TimeSeriesRun& a, const TimeSeriesRun& b) {
+    return a.m_phase == b.m_phase && a.m_mode == b.m_mode &&
+           a.m_startDepth == b.m_startDepth && a.m_endDepth == b.m_endDepth &&
+           a.m_o2Percent == b.m_o2Percent && a.m_hePercent == b.m_hePercent && a.m_gf == b.m_gf;
+}
+
+TimeSeries::TimeSeries(const TimeProfile& profile, ThreadPool* pool) {
+    DC_TRACE_SCOPE("TimeSeries::TimeSeries");
+    int nbSamples = profile.size();
+
+    m_runTime.resize(nbSamples);
+    m_depth.resize(nbSamples);
+    m_cnsTotalSingleDive.resize(nbSamples);
+    m_cnsTotalMultipleDives.resize(nbSamples);
+    m_otuTotal.resize(nbSamples);
+    m_gfSurface.resize(nbSamples);
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        m_pN2[j].resize(nbSamples);
+        m_pHe[j].resize(nbSamples);
+    }
+
+    // One run per step with samples, unless it repeats the attributes of the last run
+    for (int i = 0; i < profile.nbOfSteps(); i++) {
+        if (profile.getFirstSample(i + 1) == profile.getFirstSample(i)) continue;
+
+        const DiveStep& step = profile.getStep(i);
+        TimeSeriesRun run{profile.getFirstSample(i), step.m_phase, step.m_mode, (float) step.m_startDepth, (float) step.m_endDepth,
+                          (float) step.m_o2Percent, (float) step.m_hePercent, (float) step.m_gf};
+        if (m_runs.empty() || !isSameRun(m_runs.back(), run)) {
+            m_runs.push_back(run);
+        }
+    }
+
+    // The first sample of a chunk starts from the loading at the end of the step before it,
+    // known from the plan, so chunks are independent; CNS and OTU totals come from the
+    // view's per-step prefix sums rather than from the samples before
+    bool parallel = (pool != nullptr && pool->size() > 1 && nbSamples >= 2 * TIME_SERIES_CHUNK);
+    int nbChunks = parallel ? (nbSamples + TIME_SERIES_CHUNK - 1) / TIME_SERIES_CHUNK : 1;
+
+    auto fillChunk = [&](std::size_t chunk) {
+        DC_TRACE_SCOPE("TimeSeries chunk");
+        int begin = (int) ((long long) chunk * nbSamples / nbChunks);
+        int end = (int) ((long long) (chunk + 1) * nbSamples / nbChunks);
+
+        DiveStep sample;
+        for (int i = begin; i < end; i++) {
+            profile.getSample(i, (i > begin) ? &sample : nullptr, sample);
+            setSample(i, sample, profile.getStep(profile.getStepIndex(i)));
+        }
+    };
+
+    if (parallel) {
+        pool->parallelFor(nbChunks, fillChunk);
+    }
+    else {
+        fillChunk(0);
+    }
+}
+
+void TimeSeries::setSample(int index, const DiveStep& sample, const DiveStep& step) {
+    double elapsed = sample.m_runTime - (step.m_runTime - step.m_time);
+    double depth = (step.m_time == 0) ? step.m_endDepth
+                                      : step.m_startDepth + (step.m_endDepth - step.m_startDepth) * elapsed / step.m_time;
+
+    m_runTime[index] = (float) sample.m_runTime;
+    m_depth[index] = (float) depth;
+    m_cnsTotalSingleDive[index] = (float) sample.m_cnsTotalSingleDive;
+    m_cnsTotalMultipleDives[index] = (float) sample.m_cnsTotalMultipleDives;
+    m_otuTotal[index] = (float) sample.m_otuTotal;
+    m_gfSurface[index] = (float) sample.m_gfSurface;
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        m_pN2[j][index] = (float) sample.m_ppActual.pN2(j);
+        m_pHe[j][index] = (float) sample.m_ppActual.pHe(j);
+    }
+}
+
+const TimeSeriesRun& TimeSeries::getRun(int sample) const {
+    auto next = std::upper_bound(m_runs.begin(), m_runs.end(), sample,
+                                 [](int index, const TimeSeriesRun& run) { return index < run.m_firstSample; });
+    return *(next - 1);
+}
+
+std::size_t TimeSeries::getMemoryUsage() const {
+    std::size_t columns = 6 + 2 * NUM_COMPARTMENTS;
+    return m_runs.capacity() * sizeof(TimeSeriesRun) + columns * m_runTime.capacity() * sizeof(float);
+}
+
+} // namespace DiveComputer
@@ -0,0 +1,67 @@
+#ifndef TIME_SERIES_HPP
+#define TIME_SERIES_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "enum.hpp"
+#include "compartments.hpp"
+#include "time_profile.hpp"
+
+namespace DiveComputer {
+
+class ThreadPool;
+
+// Samples filled by one task when the series is built on a thread pool
+const int TIME_SERIES_CHUNK = 512;
+
+// Step attributes, constant over a run of consecutive samples
+struct TimeSeriesRun {
+    int      m_firstSample;
+    Phase    m_phase;
+    stepMode m_mode;
+    float    m_startDepth;
+    float    m_endDepth;
+    float    m_o2Percent;
+    float    m_hePercent;
+    float    m_gf;
+};
+
+// Compact columnar copy of a time profile, for keeping many dives around.
+// Step attributes are run-length encoded; the values that change every sample are dense
+// float columns indexed by sample, one column per compartment and inert gas, so scanning
+// one metric touches only that metric
+class TimeSeries {
+public:
+    TimeSeries() = default;
+
+    // With a pool, long profiles are filled in chunks of samples in parallel
+    explicit TimeSeries(const TimeProfile& profile, ThreadPool* pool = nullptr);
+
+    int size() const { return (int) m_runTime.size(); }
+
+    // Attributes of the step sample falls in
+    const TimeSeriesRun& getRun(int sample) const;
+
+    // Heap memory held by the columns and runs, in bytes
+    std::size_t getMemoryUsage() const;
+
+    std::vector<TimeSeriesRun> m_runs;
+
+    std::vector<float> m_runTime;
+    std::vector<float> m_depth;
+    std::vector<float> m_cnsTotalSingleDive;
+    std::vector<float> m_cnsTotalMultipleDives;
+    std::vector<float> m_otuTotal;
+    std::vector<float> m_gfSurface;
+    std::array<std::vector<float>, NUM_COMPARTMENTS> m_pN2;
+    std::array<std::vector<float>, NUM_COMPARTMENTS> m_pHe;
+
+private:
+    void setSample(int index, const DiveStep& sample, const DiveStep& step);
+};
+
+} // namespace DiveComputer
+
+#endif // TIME_SERIES_HPP
@@ -0,0 +1,158 @@
+#include "tissue_state.hpp"
+#include "constants.hpp"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace DiveComputer {
+
+// Per thread, so that planning threads never share a counter in the kernel; constant-initialised,
+// the increments are plain thread-local adds
+static thread_local unsigned long long t_schreinerEvaluations = 0;
+static thread_local unsigned long long t_expEvaluations = 0;
+
+TissueState::TissueState(const std::vector<CompartmentPP>& compartments) {
+    for (int j = 0; j < NUM_COMPARTMENTS && j < (int) compartments.size(); j++) {
+        pN2(j) = compartments[j].m_pN2;
+        pHe(j) = compartments[j].m_pHe;
+    }
+}
+
+CompartmentPP TissueState::getCompartmentPP(int compartment) const {
+    return CompartmentPP(pN2(compartment), pHe(compartment), pInert(compartment));
+}
+
+// Fills one lane; expm1 and a short series for small k.t avoid the cancellation in t - (1 - e) / k
+static void setSchreinerLane(SchreinerDecay& decay, int lane, double k, double time) {
+    double x = k * time;
+    double oneMinusDecay = -expm1(-x);
+
+    decay.m_decay[lane] = 1.0 - oneMinusDecay;
+    decay.m_rampOffset[lane] = (x < 1e-4) ? time * x * (0.5 - x / 6.0) : time - oneMinusDecay / k;
+}
+
+void computeSchreinerDecay(const std::array<double, TISSUE_LANES>& rateConstants, double time, SchreinerDecay& decay) {
+    decay.m_time = time;
+    decay.m_decay.fill(1.0);
+    decay.m_rampOffset.fill(0.0);
+
+    for (int j = 0; j < NUM_COMPARTMENTS; j++) {
+        setSchreinerLane(decay, j, rateConstants[j], time);
+        setSchreinerLane(decay, COMPARTMENT_STRIDE + j, rateConstants[COMPARTMENT_STRIDE + j], time);
+    }
+
+    t_expEvaluations += 2 * NUM_COMPARTMENTS;
+}
+
+void applySchreiner(const TissueState& start, TissueState& end, const SchreinerDecay& decay,
+                    double pAmbStart, double pAmbEnd, double n2Percent, double hePercent) {
+    t_schreinerEvaluations++;
+
+    double time = decay.m_time;
+    double pInspired = pAmbStart - g_constants.m_pH2O;
+    double pRate = (time == 0) ? 0 : (pAmbEnd - pAmbStart) / time;
+
+    // Inspired pressure and its rate of change, for the N2 half then the He half
+    const double pi[2] = { pInspired * n2Percent / 100.0, pInspired * hePercent / 100.0 };
+    const double r[2]  = { pRate * n2Percent / 100.0, pRate * hePercent / 100.0 };
+
+    const double* p0 = start.m_lanes.data();
+    const double* e = decay.m_decay.data();
+    const double* ramp = decay.m_rampOffset.data();
+    double* p = end.m_lanes.data();
+
+    for (int gas = 0; gas < 2; gas++) {
+        int first = gas * COMPARTMENT_STRIDE;
+        int last = first + COMPARTMENT_STRIDE;
+
+#if defined(__AVX2__)
+        __m256d vPi = _mm256_set1_pd(pi[gas]);
+        __m256d vR = _mm256_set1_pd(r[gas]);
+        for (int i = first; i < last; i += 4) {
+            __m256d delta = _mm256_sub_pd(_mm256_load_pd(p0 + i), vPi);
+            __m256d result = _mm256_add_pd(_mm256_mul_pd(delta, _mm256_load_pd(e + i)), vPi);
+            result = _mm256_add_pd(result, _mm256_mul_pd(vR, _mm256_load_pd(ramp + i)));
+            _mm256_store_pd(p + i, result);
+        }
+#elif defined(__SSE2__)
+        __m128d vPi = _mm_set1_pd(pi[gas]);
+        __m128d vR = _mm_set1_pd(r[gas]);
+        for (int i = first; i < last; i += 2) {
+            __m128d delta = _mm_sub_pd(_mm_load_pd(p0 + i), vPi);
+            __m128d result = _mm_add_pd(_mm_mul_pd(delta, _mm_load_pd(e + i)), vPi);
+            result = _mm_add_pd(result, _mm_mul_pd(vR, _mm_load_pd(ramp + i)));
+            _mm_store_pd(p + i, result);
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        float64x2_t vPi = vdupq_n_f64(pi[gas]);
+        float64x2_t vR = vdupq_n_f64(r[gas]);
+        for (int i = first; i < last; i += 2) {
+            float64x2_t delta = vsubq_f64(vld1q_f64(p0 + i), vPi);
+            float64x2_t result = vaddq_f64(vmulq_f64(delta, vld1q_f64(e + i)), vPi);
+            result = vaddq_f64(result, vmulq_f64(vR, vld1q_f64(ramp + i)));
+            vst1q_f64(p + i, result);
+        }
+#else
+        for (int i = first; i < last; i++) {
+            p[i] = (p0[i] - pi[gas]) * e[i] + pi[gas] + r[gas] * ramp[i];
+        }
+#endif
+    }
+}
+
+TissueTransform TissueTransform::identity() {
+    TissueTransform transform;
+    transform.m_scale.fill(1.0);
+    transform.m_offset.fill(0.0);
+    return transform;
+}
+
+TissueTransform TissueTransform::fromSegment(const SchreinerDecay& decay, double pAmbStart, double pAmbEnd,
+                                             double n2Percent, double hePercent) {
+    TissueTransform transform;
+
+    double time = decay.m_time;
+    double pInspired = pAmbStart - g_constants.m_pH2O;
+    double pRate = (time == 0) ? 0 : (pAmbEnd - pAmbStart) / time;
+
+    // p = e.p0 + pi.(1 - e) + r.ramp; padding lanes get a scale of 1 and no offset
+    for (int lane = 0; lane < TISSUE_LANES; lane++) {
+        double fraction = ((lane < COMPARTMENT_STRIDE) ? n2Percent : hePercent) / 100.0;
+        double e = decay.m_decay[lane];
+
+        transform.m_scale[lane] = e;
+        transform.m_offset[lane] = pInspired * fraction * (1.0 - e) + pRate * fraction * decay.m_rampOffset[lane];
+    }
+
+    return transform;
+}
+
+TissueTransform TissueTransform::then(const TissueTransform& next) const {
+    TissueTransform transform;
+    for (int lane = 0; lane < TISSUE_LANES; lane++) {
+        transform.m_scale[lane] = next.m_scale[lane] * m_scale[lane];
+        transform.m_offset[lane] = next.m_scale[lane] * m_offset[lane] + next.m_offset[lane];
+    }
+    return transform;
+}
+
+void TissueTransform::apply(const TissueState& start, TissueState& end) const {
+    for (int lane = 0; lane < TISSUE_LANES; lane++) {
+        end.m_lanes[lane] = m_scale[lane] * start.m_lanes[lane] + m_offset[lane];
+    }
+}
+
+SchreinerStats getSchreinerStats() {
+    SchreinerStats stats;
+    stats.m_evaluations = t_schreinerEvaluations;
+    stats.m_expEvaluations = t_expEvaluations;
+    return stats;
+}
+
+} // namespace DiveComputer
@@ -0,0 +1,83 @@
+#ifndef TISSUE_STATE_HPP
+#define TISSUE_STATE_HPP
+
+#include "compartments.hpp"
+#include <array>
+#include <vector>
+
+namespace DiveComputer {
+
+// Compartments padded to a whole number of SIMD registers (4 doubles for AVX2)
+const int COMPARTMENT_STRIDE = 20;
+
+// N2 lanes first, then He lanes, so one kernel pass covers both inert gases
+const int TISSUE_LANES = 2 * COMPARTMENT_STRIDE;
+
+// Inert gas loading of all compartments, stored as structure-of-arrays
+class alignas(32) TissueState {
+public:
+    TissueState() = default;
+    explicit TissueState(const std::vector<CompartmentPP>& compartments);
+
+    double& pN2(int compartment)            { return m_lanes[compartment]; }
+    double& pHe(int compartment)            { return m_lanes[COMPARTMENT_STRIDE + compartment]; }
+    double  pN2(int compartment) const      { return m_lanes[compartment]; }
+    double  pHe(int compartment) const      { return m_lanes[COMPARTMENT_STRIDE + compartment]; }
+    double  pInert(int compartment) const   { return pN2(compartment) + pHe(compartment); }
+
+    CompartmentPP getCompartmentPP(int compartment) const;
+
+    alignas(32) std::array<double, TISSUE_LANES> m_lanes{};
+};
+
+// Time dependent terms of the Schreiner equation for one duration, one entry per lane
+//   m_decay      = exp(-k.t)
+//   m_rampOffset = t - (1 - exp(-k.t)) / k
+// Padding lanes hold a decay of 1 and no offset, so they are left untouched
+class alignas(32) SchreinerDecay {
+public:
+    double m_time{0.0};
+    alignas(32) std::array<double, TISSUE_LANES> m_decay{};
+    alignas(32) std::array<double, TISSUE_LANES> m_rampOffset{};
+};
+
+void computeSchreinerDecay(const std::array<double, TISSUE_LANES>& rateConstants, double time, SchreinerDecay& decay);
+
+// Schreiner equation for every compartment and both inert gases in a single pass
+// p = (p0 - pi) * exp(-k.t) + pi + r * (t - (1 - exp(-k.t)) / k)
+void applySchreiner(const TissueState& start, TissueState& end, const SchreinerDecay& decay,
+                    double pAmbStart, double pAmbEnd, double n2Percent, double hePercent);
+
+// Effect of a segment on the tissues, lane by lane: p_end = m_scale * p_start + m_offset.
+// The Schreiner equation is affine in p0, so a run of segments composes into one transform
+// and a constant depth segment of any duration costs the same as a one minute step
+class alignas(32) TissueTransform {
+public:
+    // Leaves the tissues unchanged
+    static TissueTransform identity();
+
+    // Same segment as applySchreiner() with these arguments
+    static TissueTransform fromSegment(const SchreinerDecay& decay, double pAmbStart, double pAmbEnd,
+                                       double n2Percent, double hePercent);
+
+    // This transform followed by next
+    TissueTransform then(const TissueTransform& next) const;
+
+    void apply(const TissueState& start, TissueState& end) const;
+
+    alignas(32) std::array<double, TISSUE_LANES> m_scale{};
+    alignas(32) std::array<double, TISSUE_LANES> m_offset{};
+};
+
+// Running totals of the calling thread since it started, used by the benchmark to count
+// transcendental calls; work handed to other threads is counted there
+struct SchreinerStats {
+    unsigned long long m_evaluations{0};     // applySchreiner calls
+    unsigned long long m_expEvaluations{0};  // exp() calls made building decay terms
+};
+
+SchreinerStats getSchreinerStats();
+
+} // namespace DiveComputer
+
+#endif // TISSUE_STATE_HPP
@@ -0,0 +1,156 @@
+#include "trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DiveComputer {
+
+namespace {
+
+struct TraceEvent {
+    const char* m_name;
+    long long   m_start;      // in ns
+    long long   m_duration;   // in ns
+};
+
+// Spans of one thread. The registry shares it, so it outlives the thread; its mutex is
+// only contended while the trace is written
+struct ThreadTrace {
+    int m_threadId{0};
+    std::mutex m_mutex;
+    std::vector<TraceEvent> m_events;
+};
+
+// About 24 MB per thread; once full, later spans are dropped
+const std::size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+#ifdef DIVECOMPUTER_TRACE
+std::atomic<bool> s_enabled{true};
+#else
+std::atomic<bool> s_enabled{false};
+#endif
+
+std::mutex s_registryMutex;
+
+std::vector<std::shared_ptr<ThreadTrace>>& getRegistry() {
+    static std::vector<std::shared_ptr<ThreadTrace>> registry;
+    return registry;
+}
+
+long long getTime() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+ThreadTrace& getThreadTrace() {
+    thread_local std::shared_ptr<ThreadTrace> trace = [] {
+        auto created = std::make_shared<ThreadTrace>();
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        created->m_threadId = (int) getRegistry().size() + 1;
+        getRegistry().push_back(created);
+        return created;
+    }();
+    return *trace;
+}
+
+// Span names are literals from the code, but stay valid JSON whatever they hold
+void writeJsonString(FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') std::fputc('\\', file);
+        if ((unsigned char) *c >= 0x20) std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+TraceScope::TraceScope(const char* name)
+    : m_name(name)
+    , m_start(s_enabled.load(std::memory_order_relaxed) ? getTime() : -1)
+{
+}
+
+TraceScope::~TraceScope() {
+    if (m_start < 0) return;
+
+    long long end = getTime();
+    ThreadTrace& trace = getThreadTrace();
+    std::lock_guard<std::mutex> lock(trace.m_mutex);
+    if (trace.m_events.size() < MAX_EVENTS_PER_THREAD) {
+        trace.m_events.push_back({m_name, m_start, end - m_start});
+    }
+}
+
+namespace Trace {
+
+bool isAvailable() {
+#ifdef DIVECOMPUTER_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void setEnabled(bool enabled) {
+    s_enabled.store(enabled && isAvailable(), std::memory_order_relaxed);
+}
+
+bool isEnabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void clear() {
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    for (const auto& trace : getRegistry()) {
+        std::lock_guard<std::mutex> traceLock(trace->m_mutex);
+        trace->m_events.clear();
+    }
+}
+
+std::size_t getEventCount() {
+    std::size_t count = 0;
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    for (const auto& trace : getRegistry()) {
+        std::lock_guard<std::mutex> traceLock(trace->m_mutex);
+        count += trace->m_events.size();
+    }
+    return count;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    // Complete ("X") events in microseconds, one track per thread
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    for (const auto& trace : getRegistry()) {
+        std::lock_guard<std::mutex> traceLock(trace->m_mutex);
+
+        std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                     first ? "" : ",", trace->m_threadId, trace->m_threadId);
+        first = false;
+
+        for (const TraceEvent& event : trace->m_events) {
+            std::fprintf(file, ",\n{\"name\":");
+            writeJsonString(file, event.m_name);
+            std::fprintf(file, ",\"cat\":\"divecomputer\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                         event.m_start / 1000.0, event.m_duration / 1000.0, trace->m_threadId);
+        }
+    }
+
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+} // namespace Trace
+
+} // namespace DiveComputer
@@ -0,0 +1,53 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace DiveComputer {
+
+// Scoped spans recorded per thread, written out as Chrome trace-event JSON
+// (chrome://tracing or ui.perfetto.dev). Spans are only compiled into builds defining
+// DIVECOMPUTER_TRACE (qmake CONFIG+=trace); elsewhere DC_TRACE_SCOPE expands to nothing
+namespace Trace {
+    // Whether this build records spans
+    bool isAvailable();
+
+    // Recording can be paused; it is on from start-up in trace builds
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    // Drops the spans recorded so far
+    void clear();
+    std::size_t getEventCount();
+
+    // Writes the spans recorded so far; false if the file cannot be written
+    bool writeChromeTrace(const std::string& path);
+}
+
+// Records the time from its construction to its destruction as a span of the calling thread.
+// name is kept as is: it must be a string literal
+class TraceScope {
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    long long   m_start;    // ns since the trace started, -1 when not recording
+};
+
+} // namespace DiveComputer
+
+#ifdef DIVECOMPUTER_TRACE
+#define DC_TRACE_CONCAT_INNER(a, b) a##b
+#define DC_TRACE_CONCAT(a, b) DC_TRACE_CONCAT_INNER(a, b)
+#define DC_TRACE_SCOPE(name) ::DiveComputer::TraceScope DC_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define DC_TRACE_SCOPE(name) ((void) 0)
+#endif
+
+#endif // TRACE_HPP
@@ -0,0 +1,53 @@
+#include "ui_utils.hpp"
+#include <algorithm>
+
+namespace DiveComputer {
+
+void setWindowSizeAndPosition(QWidget* window, int preferredWidth, int preferredHeight, WindowPosition position) {
+    
+    int margin = 10;
+
+    // Get the screen resolution using the newer QScreen approach
+    QScreen *screen = QApplication::primaryScreen();
+    QRect screenGeometry = screen->availableGeometry();
+    
+    // Calculate appropriate window size (constrained by screen size)
+    int windowWidth = std::min(screenGeometry.width() - margin, preferredWidth);
+    int windowHeight = std::min(screenGeometry.height() - margin, preferredHeight);
+    window->resize(windowWidth, windowHeight);
+    
+    // Calculate window position based on requested position
+    int x, y;
+    
+    switch (position) {
+        case WindowPosition::CENTER:
+            x = (screenGeometry.width() - window->width()) / 2;
+            y = (screenGeometry.height() - window->height()) / 2;
+            break;
+            
+        case WindowPosition::TOP_LEFT:
+            x = screenGeometry.left();
+            y = screenGeometry.top();
+            break;
+            
+        case WindowPosition::TOP_RIGHT:
+            x = screenGeometry.right() - window->width();
+            y = screenGeometry.top();
+            break;
+            
+        case WindowPosition::BOTTOM_LEFT:
+            x = screenGeometry.left();
+            y = screenGeometry.bottom() - window->height();
+            break;
+            
+        case WindowPosition::BOTTOM_RIGHT:
+            x = screenGeometry.right() - window->width();
+            y = screenGeometry.bottom() - window->height();
+            break;
+    }
+    
+    // Move the window to the calculated position
+    window->move(x, y);
+}
+
+} // namespace DiveComputer
@@ -2,10 +2,14 @@
 #define UI_UTILS_HPP
 
 #include "qtheaders.hpp"
+#include "enum.hpp"
 #include <memory>
 
 namespace DiveComputer {
 
+// Size the window to fit the primary screen and place it at the requested position
+void setWindowSizeAndPosition(QWidget* window, int preferredWidth, int preferredHeight, WindowPosition position);
+
 // Utility function to create a delete button widget
 // Takes a callback function that will be called when the delete button is clicked
 template<typename Func>